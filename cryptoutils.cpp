@@ -1,103 +1,246 @@
+#include <avr/pgmspace.h>
 #include "cryptoutils.h"
 
-uint8_t hex_to_int (uint8_t c) {
-  uint8_t v = 0;
-  if ((c>=0x30)&&(c<=0x39))
-    v = c - 0x30;
-  if ((c>=0x41)&&(c<=0x46))
-    v = c - 0x37;
-  if ((c>=0x61)&&(c<=0x66))
-    v = c - 0x57;
-  return v;
+/********************************************************************************
+ * hex and word codec
+ *
+ * hex_decode and hex_encode convert between text and bytes, two digits a
+ * byte, high nibble first; either case is read, lower case written. the
+ * digits go through a 256 byte table, a pair at a time, and nothing stops
+ * at a NUL : len is the length of the text. load_words and store_words
+ * convert between bytes and state words, which NORX keeps little endian
+ * (word i is bytes i*W/8 on, the lowest byte first), hex_to_words and
+ * words_to_hex do both steps. hex_read_word and hex_write_word are the
+ * single number form, most significant digit first, W/4 digits.
+ *
+ * the decoders return HEX_OK or HEX_ERR_*, they print nothing. hex_decode
+ * writes at most max bytes and sets *n to their number, even on error
+ */
+
+static const uint8_t HEX_NIBBLES[256] PROGMEM = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+static const char HEX_DIGITS[16] PROGMEM = {
+  '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
+};
+
+#define HEX_NIBBLE(c) pgm_read_byte (&(HEX_NIBBLES[(uint8_t)(c)]))
+
+/* the digits are decoded without a test each : the table gives 0xff for
+   anything else, so the OR of all the nibbles says if one was bad, and
+   only then is the text looked at again */
+
+/* index of the first pair with a bad digit, or len/2 */
+static size_t hex_bad (const char* hex, size_t len) {
+  size_t i;
+  for (i=0;i<len/2;i++)
+    if ((HEX_NIBBLE (hex[2*i]) | HEX_NIBBLE (hex[2*i+1])) & 0xf0) break;
+  return i;
 }
 
-uint32_t read_32_bits (char* hex_str) {
-  uint32_t len;
-  uint32_t val;
-  uint8_t i;
-  uint8_t c;
-  uint8_t v;
-  len = strlen (hex_str);
-  if (len<8) {
-    Serial.println();
-    Serial.print ("length : ");
-    Serial.println (len);
-    Serial.println ("problem, length less than 8 in read_32_bits");
-    Serial.println (hex_str);
-    return 0;
+uint8_t hex_decode (uint8_t* out, size_t max, const char* hex, size_t len, size_t* n) {
+  size_t i;
+  uint8_t hi, lo, bad = 0;
+  *n = 0;
+  if ((len & 1)||(len/2 > max)) return HEX_ERR_LENGTH;
+  for (i=0;i<len/2;i++,hex+=2) {
+    hi = HEX_NIBBLE (hex[0]);
+    lo = HEX_NIBBLE (hex[1]);
+    bad |= hi | lo;
+    out[i] = (hi << 4) | lo;
   }
-  
-  val = 0;
-  for (i=0;i<8;i++) {
-    val<<=4;
-    c = hex_str[i];
-    v = hex_to_int (c);
-    val |= v;
+  *n = len/2;
+  if (bad & 0xf0) {
+    *n = hex_bad (hex - len, len);
+    return HEX_ERR_DIGIT;
   }
-  return val;
+  return HEX_OK;
 }
 
-uint64_t read_64_bits (char* hex_str) {
-  uint32_t len;
-  uint64_t val;
-  uint8_t i;
-  uint8_t c;
-  uint8_t v;
-  len = strlen (hex_str);
-  if (len<16) {
-    Serial.println();
-    Serial.print ("length : ");
-    Serial.println (len);
-    Serial.println ("problem, length less than 8 in read_32_bits");
-    Serial.println (hex_str);
-    return 0;
+/* writes 2*len digits, no NUL, and returns their number */
+size_t hex_encode (char* out, const uint8_t* in, size_t len) {
+  size_t i;
+  for (i=0;i<len;i++) {
+    *out++ = pgm_read_byte (&(HEX_DIGITS[in[i] >> 4]));
+    *out++ = pgm_read_byte (&(HEX_DIGITS[in[i] & 0x0f]));
   }
-  
-  val = 0;
-  for (i=0;i<16;i++) {
-    val<<=4;
-    c = hex_str[i];
-    v = hex_to_int (c);
-    val |= v;
+  return 2*len;
+}
+
+/* n words of bits (32 or 64) from n*bits/8 bytes */
+void load_words (uint8_t bits, void* w, const uint8_t* p, size_t n) {
+  uint32_t* w32 = (uint32_t*)w;
+  uint64_t* w64 = (uint64_t*)w;
+  uint32_t v;
+  size_t i;
+  for (i=0;i<n;i++,p+=bits>>3) {
+    v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    if (bits==32) w32[i] = v;
+    else w64[i] = v | ((uint64_t)((uint32_t)p[4] | ((uint32_t)p[5] << 8) |
+                                  ((uint32_t)p[6] << 16) | ((uint32_t)p[7] << 24)) << 32);
   }
-  return val;
 }
 
-#define HEX_DIGIT(v) ( ( ((v)>=0) && ((v)<=15) ) \
-                       ? \
-                         ( ((v)>=10) ? ((char) ((v)+0x57)) : ((char) ((v)+0x30)) ) \
-                       : \
-                         '?' \
-                     )
+void store_words (uint8_t bits, uint8_t* p, const void* w, size_t n) {
+  const uint32_t* w32 = (const uint32_t*)w;
+  const uint64_t* w64 = (const uint64_t*)w;
+  uint64_t v;
+  uint8_t k;
+  size_t i;
+  for (i=0;i<n;i++) {
+    v = (bits==32) ? w32[i] : w64[i];
+    for (k=0;k<(bits>>3);k++,v>>=8) *p++ = (uint8_t)v;
+  }
+}
 
-void _print_32_bits (char* buffer, uint32_t val) {
+/* four digit pairs, the first one the lowest byte */
+static inline uint32_t hex_le32 (const char* hex, uint8_t* bad) {
+  uint32_t v = 0;
+  uint8_t i, hi, lo;
+  for (i=0;i<4;i++,hex+=2) {
+    hi = HEX_NIBBLE (hex[0]);
+    lo = HEX_NIBBLE (hex[1]);
+    *bad |= hi | lo;
+    v |= (uint32_t)((hi << 4) | lo) << (8*i);
+  }
+  return v;
+}
+
+/* n words from exactly n*bits/4 digits, without a byte copy in between */
+uint8_t hex_to_words (uint8_t bits, void* w, size_t n, const char* hex, size_t len) {
+  uint32_t* w32 = (uint32_t*)w;
+  uint64_t* w64 = (uint64_t*)w;
+  uint8_t bad = 0;
+  size_t i;
+  if (len!=(size_t)(bits>>2)*n) return HEX_ERR_LENGTH;
+  for (i=0;i<n;i++) {
+    if (bits==32) {
+      w32[i] = hex_le32 (hex, &bad);
+      hex += 8;
+    } else {
+      w64[i] = hex_le32 (hex, &bad);
+      w64[i] |= (uint64_t)hex_le32 (hex+8, &bad) << 32;
+      hex += 16;
+    }
+  }
+  return (bad & 0xf0) ? HEX_ERR_DIGIT : HEX_OK;
+}
+
+/* writes n*bits/4 digits, no NUL, and returns their number */
+size_t words_to_hex (uint8_t bits, char* out, const void* w, size_t n) {
+  const uint32_t* w32 = (const uint32_t*)w;
+  const uint64_t* w64 = (const uint64_t*)w;
+  uint64_t v;
+  uint8_t k;
+  size_t i;
+  for (i=0;i<n;i++) {
+    v = (bits==32) ? w32[i] : w64[i];
+    for (k=0;k<(bits>>3);k++,v>>=8) {
+      *out++ = pgm_read_byte (&(HEX_DIGITS[(v >> 4) & 0x0f]));
+      *out++ = pgm_read_byte (&(HEX_DIGITS[v & 0x0f]));
+    }
+  }
+  return (bits>>2)*n;
+}
+
+/* bits/4 digits, most significant first. text ending before them is a
+   length error, anything after them is ignored. a NUL is a bad digit to
+   the table, so nothing past the end of the text is read */
+uint8_t hex_read_word (uint8_t bits, const char* hex, uint64_t* v) {
+  uint32_t h = 0, l = 0;
+  uint8_t i, c;
+  for (i=0;i<(bits>>2);i++) {
+    c = HEX_NIBBLE (hex[i]);
+    if (c & 0xf0) {
+      *v = 0;
+      return hex[i] ? HEX_ERR_DIGIT : HEX_ERR_LENGTH;
+    }
+    h = (h << 4) | (l >> 28);
+    l = (l << 4) | c;
+  }
+  *v = ((uint64_t)h << 32) | l;
+  return HEX_OK;
+}
+
+/* writes bits/4 digits, no NUL */
+void hex_write_word (uint8_t bits, char* out, uint64_t v) {
   uint8_t i;
-  uint8_t v;
-  for (i=0;i<8;i++)
-    buffer[i] = ( HEX_DIGIT ( ( val >> ( (7 - i) * 4 ) ) & 0x0f ) );
+  for (i=bits>>2;i>0;i--,v>>=4) out[i-1] = pgm_read_byte (&(HEX_DIGITS[v & 0x0f]));
+}
+
+/* the word forms used by dump_state, 0 on bad text */
+uint32_t read_32_bits (char* hex_str) {
+  uint64_t v;
+  if (hex_read_word (32, hex_str, &v)!=HEX_OK) return 0;
+  return v;
+}
+
+uint64_t read_64_bits (char* hex_str) {
+  uint64_t v;
+  if (hex_read_word (64, hex_str, &v)!=HEX_OK) return 0;
+  return v;
+}
+
+void _print_32_bits (char* buffer, uint32_t val) {
+  hex_write_word (32, buffer, val);
 }
 
 void print_32_bits (uint32_t val) {
   char buffer[9];
-  memset(buffer, 0, sizeof(buffer));
-  _print_32_bits (buffer, val);
+  hex_write_word (32, buffer, val);
+  buffer[8] = 0;
   Serial.print (buffer);
 }
 
 void _print_64_bits (char* buffer, uint64_t val) {
-  uint8_t i;
-  uint8_t v;
-  for (i=0;i<16;i++)
-    buffer[i] = ( HEX_DIGIT ( ( val >> ( (15 - i) * 4 ) ) & 0x0f ) );
+  hex_write_word (64, buffer, val);
 }
 
 void print_64_bits (uint64_t val) {
   char buffer[17];
-  memset(buffer, 0, sizeof(buffer));
-  _print_64_bits (buffer, val);
+  hex_write_word (64, buffer, val);
+  buffer[16] = 0;
   Serial.print (buffer);
 }
 
+/********************************************************************************
+ * CRC-32 (IEEE 802.3, reflected), a nibble at a time from a 64 byte table.
+ * crc is 0 to start, or the value returned for the previous chunk
+ */
+
+static const uint32_t CRC32_NIBBLES[16] PROGMEM = {
+  0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL,
+  0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+  0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL,
+  0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+};
+
+uint32_t crc32 (uint32_t crc, const uint8_t* p, size_t len) {
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ pgm_read_dword (&(CRC32_NIBBLES[crc & 0x0f]));
+    crc = (crc >> 4) ^ pgm_read_dword (&(CRC32_NIBBLES[crc & 0x0f]));
+  }
+  return ~crc;
+}
+
 /********************************************************************************
  * testing functionnality
  *
@@ -105,9 +248,9 @@ void print_64_bits (uint64_t val) {
 
 bool _TEST(bool c) {
   if ((c)) 
-    Serial.println("PASS"); 
+    Serial.println(F("PASS")); 
   else 
-    Serial.println("FAIL"); 
+    Serial.println(F("FAIL")); 
   return (c);
 }                 
 
@@ -118,26 +261,26 @@ int _test_print_32_bits (void) {
   int res = 0;
   
   memset(buffer, 0, sizeof(buffer));
-  Serial.println ("* Testing print_32_bits");
+  Serial.println (F("* Testing print_32_bits"));
   Serial.println (expected);
   _print_32_bits (buffer, 0x12345678);
   _print_32_bits (buffer+8, 0x9abcdef0);
   Serial.println(buffer);
   len = strlen(expected);
-  _TEST ((strncmp(buffer, expected, len)==0));
+  return _TEST ((strncmp(buffer, expected, len)==0));
 }
 
 int _test_read_32_bits (void) {
   uint32_t   l;
   char*      s;
 
-  Serial.println ("* Testing read_32_bits");
+  Serial.println (F("* Testing read_32_bits"));
   s = "01234567";
   Serial.println (s);
   l = read_32_bits (s);
   print_32_bits (l);
   Serial.println();
-  _TEST (l==0x01234567);
+  return _TEST (l==0x01234567);
 }
 
 int _test_print_64_bits (void) {
@@ -147,25 +290,67 @@ int _test_print_64_bits (void) {
   int res = 0;
   
   memset(buffer, 0, sizeof(buffer));
-  Serial.println ("* Testing print_64_bits");
+  Serial.println (F("* Testing print_64_bits"));
   Serial.println (expected);
   _print_64_bits (buffer, 0x123456789abcdef0);
   Serial.println(buffer);
   len = strlen(expected);
-  _TEST ((strncmp(buffer, expected, len)==0));
+  return _TEST ((strncmp(buffer, expected, len)==0));
 }
 
 int _test_read_64_bits (void) {
   uint64_t   l;
   char*      s;
 
-  Serial.println ("* Testing read_64_bits");
+  Serial.println (F("* Testing read_64_bits"));
   s = "0123456789abcdef";
   Serial.println (s);
   l = read_64_bits (s);
   print_64_bits (l);
   Serial.println();
-  _TEST (l==0x0123456789abcdef);
+  return _TEST (l==0x0123456789abcdef);
+}
+
+int _test_crc32 (void) {
+  const char* s = "123456789";
+  uint32_t c;
+
+  Serial.println (F("* Testing crc32"));
+  c = crc32 (0, (const uint8_t*)s, 4);
+  c = crc32 (c, (const uint8_t*)s + 4, 5);
+  print_32_bits (c);
+  Serial.println();
+  return _TEST (c==0xCBF43926UL);
+}
+
+int _test_hex (void) {
+  const char* text = "00112233445566778899AABBccddeeff";
+  const uint32_t w32[4] = { 0x33221100UL, 0x77665544UL, 0xbbaa9988UL, 0xffeeddccUL };
+  const uint64_t w64[2] = { 0x7766554433221100ULL, 0xffeeddccbbaa9988ULL };
+  uint8_t b[16];
+  uint32_t r32[4];
+  uint64_t r64[2], v;
+  char out[33];
+  size_t n;
+  bool ok = 1;
+
+  Serial.println (F("* Testing hex codec"));
+  Serial.println (text);
+  ok &= (hex_decode (b, sizeof(b), text, 32, &n)==HEX_OK) && (n==16) && (b[10]==0xaa);
+  ok &= (hex_to_words (32, r32, 4, text, 32)==HEX_OK) && !memcmp (r32, w32, sizeof(w32));
+  ok &= (hex_to_words (64, r64, 2, text, 32)==HEX_OK) && !memcmp (r64, w64, sizeof(w64));
+  out[words_to_hex (64, out, r64, 2)] = 0;
+  Serial.println (out);
+  ok &= (strcmp (out, "00112233445566778899aabbccddeeff")==0);
+  ok &= (hex_read_word (64, "0123456789abcdef", &v)==HEX_OK) && (v==0x0123456789abcdefULL);
+  // errors, and how far hex_decode got
+  ok &= (hex_decode (b, sizeof(b), text, 31, &n)==HEX_ERR_LENGTH);
+  ok &= (hex_decode (b, 15, text, 32, &n)==HEX_ERR_LENGTH);
+  ok &= (hex_decode (b, sizeof(b), "0011x233", 8, &n)==HEX_ERR_DIGIT) && (n==2);
+  ok &= (hex_to_words (32, r32, 4, text, 30)==HEX_ERR_LENGTH);
+  ok &= (hex_read_word (32, "0123", &v)==HEX_ERR_LENGTH);
+  ok &= (hex_read_word (32, "01g34567", &v)==HEX_ERR_DIGIT);
+  return _TEST (ok);
 }
 
 int test_cryptoutils (void) {
@@ -173,6 +358,8 @@ int test_cryptoutils (void) {
   if (!_test_read_32_bits()) return 0;
   if (!_test_print_64_bits()) return 0;
   if (!_test_read_64_bits()) return 0;
+  if (!_test_hex()) return 0;
+  if (!_test_crc32()) return 0;
   return 1;
 }
 
@@ -4,10 +4,25 @@
 #include "Arduino.h"
 
 
+// hex codec, see cryptoutils.cpp. the decoders return HEX_OK or an error
+#define HEX_OK          0
+#define HEX_ERR_LENGTH  1   // odd or short text, or no room for the output
+#define HEX_ERR_DIGIT   2   // not a hex digit
+
+uint8_t hex_decode (uint8_t* out, size_t max, const char* hex, size_t len, size_t* n);
+size_t hex_encode (char* out, const uint8_t* in, size_t len);
+void load_words (uint8_t bits, void* w, const uint8_t* p, size_t n);
+void store_words (uint8_t bits, uint8_t* p, const void* w, size_t n);
+uint8_t hex_to_words (uint8_t bits, void* w, size_t n, const char* hex, size_t len);
+size_t words_to_hex (uint8_t bits, char* out, const void* w, size_t n);
+uint8_t hex_read_word (uint8_t bits, const char* hex, uint64_t* v);
+void hex_write_word (uint8_t bits, char* out, uint64_t v);
+
 uint32_t read_32_bits (char* hex_str);
 uint64_t read_64_bits (char* hex_str);
 void print_32_bits (uint32_t val);
 void print_64_bits (uint64_t val);
+uint32_t crc32 (uint32_t crc, const uint8_t* p, size_t len);
 bool _TEST(bool c);
 int test_cryptoutils (void);
 
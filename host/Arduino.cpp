@@ -0,0 +1,166 @@
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include "Arduino.h"
+
+HostSerial Serial;
+
+/***************************************************************************
+ * timing
+ */
+
+static uint64_t _now_us (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t _start_us = _now_us ();
+
+unsigned long millis (void) {
+  return (unsigned long)((_now_us () - _start_us) / 1000);
+}
+
+unsigned long micros (void) {
+  return (unsigned long)(_now_us () - _start_us);
+}
+
+void delay (unsigned long ms) {
+  struct timespec ts;
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (ms % 1000) * 1000000;
+  nanosleep (&ts, NULL);
+}
+
+/***************************************************************************
+ * serial port on stdin / stdout, or on a descriptor (a pty, a tty) given
+ * to attach. on a descriptor, like on the board, read and available do
+ * not wait : available is the number of bytes there, read -1 when there
+ * are none
+ */
+
+HostSerial::HostSerial (void) {
+  this->out = stdout;
+  this->in = stdin;
+  this->fd = -1;
+}
+
+void HostSerial::begin (unsigned long baud) {
+}
+
+void HostSerial::end (void) {
+}
+
+void HostSerial::attach (int fd) {
+  if (this->out) fflush (this->out);
+  this->fd = fd;
+}
+
+int HostSerial::available (void) {
+  int n = 0;
+  if (this->fd<0) return !feof (this->in);
+  if (ioctl (this->fd, FIONREAD, &n)<0) return 0;
+  return n;
+}
+
+// writes on the host wait for room, so there is always some
+int HostSerial::availableForWrite (void) {
+  return 4096;
+}
+
+int HostSerial::read (void) {
+  uint8_t c;
+  if (this->fd<0) return fgetc (this->in);
+  if ((this->available ()<=0)||(::read (this->fd, &c, 1)!=1)) return -1;
+  return c;
+}
+
+int HostSerial::peek (void) {
+  int c = fgetc (this->in);
+  if (c!=EOF) ungetc (c, this->in);
+  return c;
+}
+
+void HostSerial::flush (void) {
+  if ((this->fd<0)&&this->out) fflush (this->out);
+}
+
+size_t HostSerial::write (uint8_t c) {
+  return this->write (&c, 1);
+}
+
+size_t HostSerial::write (const uint8_t* buf, size_t len) {
+  size_t n = 0;
+  ssize_t r;
+  if (this->fd<0) {
+    if (this->out) fwrite (buf, 1, len, this->out);
+    return len;
+  }
+  while (n<len) {
+    r = ::write (this->fd, buf + n, len - n);
+    if (r<=0) break;
+    n += r;
+  }
+  return n;
+}
+
+void HostSerial::print_number (unsigned long n, uint8_t base) {
+  char buf[8 * sizeof(long) + 1];
+  char* p = &buf[sizeof(buf) - 1];
+  uint8_t d;
+  *p = 0;
+  if (base<2) base = 10;
+  do {
+    d = n % base;
+    n /= base;
+    *--p = d < 10 ? d + '0' : d + 'A' - 10;
+  } while (n);
+  this->print (p);
+}
+
+void HostSerial::print (const char* s) {
+  if (this->fd>=0) this->write ((const uint8_t*)s, strlen (s));
+  else if (this->out) fputs (s, this->out);
+}
+
+void HostSerial::print (const __FlashStringHelper* s) {
+  this->print ((const char*)s);
+}
+
+void HostSerial::print (char c) {
+  this->write ((uint8_t)c);
+}
+
+void HostSerial::print (unsigned char n, int base) {
+  this->print ((unsigned long)n, base);
+}
+
+void HostSerial::print (int n, int base) {
+  this->print ((long)n, base);
+}
+
+void HostSerial::print (unsigned int n, int base) {
+  this->print ((unsigned long)n, base);
+}
+
+void HostSerial::print (long n, int base) {
+  if ((base==DEC)&&(n<0)) {
+    this->print ('-');
+    n = -n;
+  }
+  this->print_number ((unsigned long)n, base);
+}
+
+void HostSerial::print (unsigned long n, int base) {
+  this->print_number (n, base);
+}
+
+void HostSerial::print (double n, int digits) {
+  char buf[64];
+  snprintf (buf, sizeof(buf), "%.*f", digits, n);
+  this->print (buf);
+}
+
+void HostSerial::println (void) {
+  this->print ("\r\n");
+}
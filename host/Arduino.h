@@ -0,0 +1,86 @@
+#ifndef __host_arduino_h_
+#define __host_arduino_h_
+
+/***************************************************************************
+ * minimal stand-in for the Arduino core, so that the library can be built
+ * and run on a Linux host. only what the sketch and the library use is
+ * provided.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// lets shared sources tell the host build from a board
+#define ARDUINO_HOST 1
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#ifndef min
+#define min(a,b) ((a)<(b)?(a):(b))
+#endif
+#ifndef max
+#define max(a,b) ((a)>(b)?(a):(b))
+#endif
+
+// flash strings, plain strings on the host
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper*)(s))
+
+unsigned long millis (void);
+unsigned long micros (void);
+void delay (unsigned long ms);
+
+class HostSerial {
+  private :
+    void print_number (unsigned long n, uint8_t base);
+
+  public :
+    // output stream, NULL silences the port
+    FILE* out;
+    // input stream for read / available
+    FILE* in;
+    // a file descriptor in place of both, see attach
+    int fd;
+
+    HostSerial (void);
+    void begin (unsigned long baud);
+    void end (void);
+    void attach (int fd);
+    int available (void);
+    int availableForWrite (void);
+    int read (void);
+    int peek (void);
+    void flush (void);
+    size_t write (uint8_t c);
+    size_t write (const uint8_t* buf, size_t len);
+
+    void print (const char* s);
+    void print (const __FlashStringHelper* s);
+    void print (char c);
+    void print (unsigned char n, int base = DEC);
+    void print (int n, int base = DEC);
+    void print (unsigned int n, int base = DEC);
+    void print (long n, int base = DEC);
+    void print (unsigned long n, int base = DEC);
+    void print (double n, int digits = 2);
+
+    void println (void);
+    template <typename T> void println (T v) { this->print (v); this->println (); }
+    template <typename T> void println (T v, int f) { this->print (v, f); this->println (); }
+
+    operator bool (void) { return 1; }
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef __host_pgmspace_h_
+#define __host_pgmspace_h_
+
+/***************************************************************************
+ * flash access stand-in, on the host PROGMEM data is ordinary memory
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+
+#define pgm_read_byte(p)  (*(const uint8_t*)(p))
+#define pgm_read_word(p)  (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define memcpy_P(d, s, n) memcpy ((d), (s), (n))
+
+#endif
@@ -0,0 +1,16 @@
+#include "Arduino.h"
+#include "norx.h"
+#include "norxbench.h"
+
+/***************************************************************************
+ * host runner for the benchmark suite, tab separated on stdout
+ */
+
+Norx norx;
+NorxBench bench (&norx);
+
+int main (int argc, char** argv) {
+  Serial.begin (9600);
+  bench.run ();
+  return 0;
+}
@@ -0,0 +1,110 @@
+#include "client.h"
+
+/***************************************************************************
+ * norxclient, the board as a coprocessor over its serial port
+ *
+ *   norxclient [-p port] [-w bits] [-r rounds] [-d d] -k key -n nonce
+ *              [-a header] [-t trailer] [-D] < in > out
+ *   norxclient [-p port] -i
+ *
+ * encrypts stdin to stdout, ciphertext then tag, or with -D decrypts it
+ * (ciphertext then tag) and writes the plaintext only once the tag has
+ * been verified. key, nonce, header and trailer are hex. -i prints the
+ * board's protocol version, widest NORX and frame size. the port defaults
+ * to /dev/ttyACM0 at 115200 baud. exits 1 on a bad tag or a board error,
+ * 2 on a usage or I/O error
+ */
+
+static int fail (const char* what, int st) {
+  fprintf (stderr, "norxclient: %s", what);
+  if (st!=NORX_PROTO_OK) fprintf (stderr, " (status %d)", st);
+  fprintf (stderr, "\n");
+  return (st>=0) ? 1 : 2;
+}
+
+static uint8_t* hex_arg (const char* hex, size_t* n) {
+  size_t len = strlen (hex);
+  uint8_t* p = (uint8_t*)malloc (len/2 + 1);
+  if (hex_decode (p, len/2, hex, len, n)!=HEX_OK) {
+    fprintf (stderr, "norxclient: bad hex %s\n", hex);
+    exit (2);
+  }
+  return p;
+}
+
+int main (int argc, char** argv) {
+  const char* port = "/dev/ttyACM0";
+  uint8_t bits = 32, rounds = 4, d = 1, version, max_bits;
+  uint8_t *key = NULL, *nonce = NULL, *h = NULL, *t = NULL, *in = NULL, *out;
+  size_t klen = 0, nlen = 0, hlen = 0, tlen = 0, len = 0, cap = 0, r;
+  bool dec = 0, info = 0;
+  uint8_t tag_len;
+  int a, fd, st;
+
+  for (a=1;a<argc;a++) {
+    if (!strcmp (argv[a], "-D")) { dec = 1; continue; }
+    if (!strcmp (argv[a], "-i")) { info = 1; continue; }
+    if (a+1>=argc) break;
+    if (!strcmp (argv[a], "-p")) port = argv[++a];
+    else if (!strcmp (argv[a], "-w")) bits = atoi (argv[++a]);
+    else if (!strcmp (argv[a], "-r")) rounds = atoi (argv[++a]);
+    else if (!strcmp (argv[a], "-d")) d = atoi (argv[++a]);
+    else if (!strcmp (argv[a], "-k")) key = hex_arg (argv[++a], &klen);
+    else if (!strcmp (argv[a], "-n")) nonce = hex_arg (argv[++a], &nlen);
+    else if (!strcmp (argv[a], "-a")) h = hex_arg (argv[++a], &hlen);
+    else if (!strcmp (argv[a], "-t")) t = hex_arg (argv[++a], &tlen);
+    else break;
+  }
+  if ((a<argc)||(!info && (!key || !nonce))) {
+    fprintf (stderr, "usage : norxclient [-p port] [-w bits] [-r rounds] [-d d] -k key -n nonce\n"
+                     "                   [-a header] [-t trailer] [-D] < in > out\n"
+                     "        norxclient [-p port] -i\n");
+    return 2;
+  }
+
+  fd = NorxClient::open_port (port, B115200);
+  if (fd<0) {
+    perror (port);
+    return 2;
+  }
+  NorxClient c (fd);
+  if ((st = c.info (&version, &max_bits))!=NORX_PROTO_OK) return fail ("no answer to INFO", st);
+  if (info) {
+    printf ("protocol %u, NORX%u, frames of %u bytes\n", version, max_bits, c.max);
+    return 0;
+  }
+  if ((klen!=(size_t)(bits>>1))||(nlen!=(size_t)(bits>>2))) {
+    fprintf (stderr, "norxclient: the key is %u bytes and the nonce %u for NORX%u\n", bits>>1, bits>>2, bits);
+    return 2;
+  }
+
+  // the whole input, the tag is its tail when decrypting
+  for (;;) {
+    if (len==cap) in = (uint8_t*)realloc (in, cap = cap ? 2*cap : 4096);
+    if (!(r = fread (in + len, 1, cap - len, stdin))) break;
+    len += r;
+  }
+  tag_len = bits >> 1;
+  if (dec && (len<tag_len)) return fail ("input shorter than the tag", NORX_PROTO_OK);
+  if (dec) len -= tag_len;
+  out = (uint8_t*)malloc (len + tag_len);
+
+  if ((st = c.key (bits, rounds, d, key))!=NORX_PROTO_OK) return fail ("KEY", st);
+  if ((st = c.call (NORX_CMD_NONCE, nonce, nlen))!=NORX_PROTO_OK) return fail ("NONCE", st);
+  if ((st = c.stream (NORX_CMD_HEADER, h, hlen, NULL))!=NORX_PROTO_OK) return fail ("HEADER", st);
+  st = c.stream (dec ? NORX_CMD_DECRYPT : NORX_CMD_ENCRYPT, in, len, out);
+  if (st!=NORX_PROTO_OK) return fail ("payload", st);
+  if ((st = c.stream (NORX_CMD_TRAILER, t, tlen, NULL))!=NORX_PROTO_OK) return fail ("TRAILER", st);
+  if (dec) {
+    st = c.call (NORX_CMD_VERIFY, in + len, tag_len);
+    if (st==NORX_PROTO_TAG) return fail ("tag does not match", NORX_PROTO_OK);
+    if (st!=NORX_PROTO_OK) return fail ("VERIFY", st);
+    fwrite (out, 1, len, stdout);
+  } else {
+    if ((st = c.call (NORX_CMD_TAG, NULL, 0, out + len))!=NORX_PROTO_OK) return fail ("TAG", st);
+    fwrite (out, 1, len + tag_len, stdout);
+  }
+  memset (key, 0, klen);
+  close (fd);
+  return 0;
+}
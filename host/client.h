@@ -0,0 +1,180 @@
+#ifndef __norx_client_h_
+#define __norx_client_h_
+
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include "Arduino.h"
+#include "norx_proto.h"
+#include "cryptoutils.h"
+
+/***************************************************************************
+ * host side of the framed serial protocol (norx_proto.h), used by the
+ * norxclient tool and the pty loopback test
+ *
+ * call sends one frame and waits for its reply. stream runs a whole
+ * buffer through a data command in chunks of the board's NORX_PROTO_MAX,
+ * with two frames in flight : the board receives the next chunk while it
+ * runs the previous one. a reply that does not come within timeout ms is
+ * NORX_CLIENT_TIMEOUT, bytes that are not a valid frame (the sketch's
+ * banner, a damaged reply) are skipped
+ */
+
+#define NORX_CLIENT_TIMEOUT -1
+#define NORX_CLIENT_IO      -2
+#define NORX_CLIENT_REPLY   -3   // a reply to another command
+
+class NorxClient {
+  private :
+    int fd;
+
+    // next byte, -1 once timeout ms have gone by without one
+    int _byte (void) {
+      struct pollfd p;
+      uint8_t c;
+      p.fd = this->fd;
+      p.events = POLLIN;
+      if (::poll (&p, 1, this->timeout)<=0) return -1;
+      if (::read (this->fd, &c, 1)!=1) return -1;
+      return c;
+    }
+
+  public :
+    int timeout;
+    uint16_t max;
+    uint8_t bits;
+
+    NorxClient (int fd) {
+      this->fd = fd;
+      this->timeout = 2000;
+      this->max = 64;
+      this->bits = 32;
+    }
+
+    // a serial port in raw mode at baud, -1 on error
+    static int open_port (const char* path, speed_t baud) {
+      struct termios t;
+      int fd = ::open (path, O_RDWR | O_NOCTTY);
+      if (fd<0) return -1;
+      if (tcgetattr (fd, &t)==0) {
+        cfmakeraw (&t);
+        cfsetspeed (&t, baud);
+        t.c_cflag |= CLOCAL | CREAD;
+        tcsetattr (fd, TCSANOW, &t);
+      }
+      return fd;
+    }
+
+    bool send (uint8_t cmd, const uint8_t* data, uint16_t len) {
+      uint8_t h[4], c[4];
+      uint32_t crc;
+      uint8_t i;
+      h[0] = NORX_PROTO_SOF;
+      h[1] = cmd;
+      h[2] = len;
+      h[3] = len >> 8;
+      crc = crc32 (crc32 (0, h + 1, 3), data, len);
+      for (i=0;i<4;i++) c[i] = crc >> (8*i);
+      return (::write (this->fd, h, 4)==4) && (::write (this->fd, data, len)==(ssize_t)len) &&
+             (::write (this->fd, c, 4)==4);
+    }
+
+    // the next valid reply : its status, data in out (room for max bytes)
+    int receive (uint8_t* cmd, uint8_t* out, uint16_t* n) {
+      uint8_t f[3 + NORX_PROTO_MAX + 1];
+      uint16_t len, i;
+      uint32_t crc;
+      int c;
+      for (;;) {
+        do {
+          if ((c = this->_byte ())<0) return NORX_CLIENT_TIMEOUT;
+        } while (c!=NORX_PROTO_SOF);
+        for (i=0;i<3;i++) {
+          if ((c = this->_byte ())<0) return NORX_CLIENT_TIMEOUT;
+          f[i] = c;
+        }
+        len = f[1] | (f[2] << 8);
+        if ((len<1)||(len>NORX_PROTO_MAX + 1)) continue;
+        for (i=0;i<len;i++) {
+          if ((c = this->_byte ())<0) return NORX_CLIENT_TIMEOUT;
+          f[3+i] = c;
+        }
+        crc = 0;
+        for (i=0;i<4;i++) {
+          if ((c = this->_byte ())<0) return NORX_CLIENT_TIMEOUT;
+          crc |= (uint32_t)c << (8*i);
+        }
+        if (crc!=crc32 (0, f, 3 + len)) continue;
+        *cmd = f[0];
+        *n = len - 1;
+        if (out) memcpy (out, f + 4, len - 1);
+        return f[3];
+      }
+    }
+
+    // one command, its status or NORX_CLIENT_*
+    int call (uint8_t cmd, const uint8_t* data, uint16_t len, uint8_t* out = NULL, uint16_t* n = NULL) {
+      uint8_t r;
+      uint16_t m;
+      int st;
+      if (!this->send (cmd, data, len)) return NORX_CLIENT_IO;
+      st = this->receive (&r, out, n ? n : &m);
+      if ((st>=0)&&(r!=(cmd | NORX_CMD_REPLY))&&(r!=NORX_CMD_ERROR)) return NORX_CLIENT_REPLY;
+      return st;
+    }
+
+    // reads the board's frame size, to chunk by
+    int info (uint8_t* version, uint8_t* max_bits) {
+      uint8_t out[8];
+      uint16_t n = 0;
+      int st = this->call (NORX_CMD_INFO, NULL, 0, out, &n);
+      if (st!=NORX_PROTO_OK) return st;
+      if (n<5) return NORX_CLIENT_REPLY;
+      *version = out[0];
+      *max_bits = out[1];
+      this->max = out[3] | (out[4] << 8);
+      return st;
+    }
+
+    int key (uint8_t bits, uint8_t rounds, uint8_t d, const uint8_t* key) {
+      uint8_t p[3 + 32];
+      int st;
+      p[0] = bits;
+      p[1] = rounds;
+      p[2] = d;
+      memcpy (p + 3, key, bits >> 1);
+      st = this->call (NORX_CMD_KEY, p, 3 + (bits >> 1));
+      memset (p, 0, sizeof(p));
+      if (st==NORX_PROTO_OK) this->bits = bits;
+      return st;
+    }
+
+    // len bytes of in through cmd, out gets the replies' data (ENCRYPT
+    // and DECRYPT), at most two chunks in flight
+    int stream (uint8_t cmd, const uint8_t* in, size_t len, uint8_t* out) {
+      size_t sent = 0, done = 0, c;
+      uint16_t n, chunk[2];
+      uint8_t r, k = 0;
+      int st = NORX_PROTO_OK, e;
+      while (done<len) {
+        while ((sent<len)&&(k<2)) {
+          c = min (len - sent, (size_t)this->max);
+          if (!this->send (cmd, in + sent, c)) return NORX_CLIENT_IO;
+          chunk[(done==sent) ? 0 : 1] = c;
+          sent += c;
+          k++;
+        }
+        e = this->receive (&r, out ? out + done : NULL, &n);
+        if (e<0) return e;
+        if ((r!=(cmd | NORX_CMD_REPLY))&&(r!=NORX_CMD_ERROR)) return NORX_CLIENT_REPLY;
+        if ((e!=NORX_PROTO_OK)&&(st==NORX_PROTO_OK)) st = e;
+        done += chunk[0];
+        chunk[0] = chunk[1];
+        k--;
+      }
+      return st;
+    }
+};
+
+#endif
@@ -0,0 +1,386 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Arduino.h"
+#include "norx.h"
+#include "norx_ct.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/***************************************************************************
+ * constant time audit, host only
+ *
+ *   norxct [samples]   dudect style timing test : every target is timed on
+ *                      one fixed input (class 0) and on random inputs
+ *                      (class 1), drawn in random order, then compared
+ *                      with Welch's t-test, raw and cropped at a few
+ *                      percentiles. |t| over CT_T_FAIL in CT_TRIES runs
+ *                      in a row fails the run
+ *   norxct taint       ctgrind style run, for valgrind : the keys, nonces,
+ *                      messages and states are marked secret (norx_ct.h)
+ *                      and memcheck reports any branch or address that
+ *                      depends on them. needs a NORX_CTGRIND=1 build
+ *
+ * see make ct and make ctgrind
+ */
+
+#define CT_SAMPLES  200000
+#define CT_T_FAIL   10.0
+#define CT_T_WARN   4.5
+#define CT_CROPS    5
+// a leak has to show in each of CT_TRIES runs, shared hosts are noisy
+#define CT_TRIES    3
+
+const uint8_t CT_PERCENTILES[CT_CROPS] = { 50, 75, 90, 95, 99 };
+
+typedef struct {
+  double n[2];
+  double mean[2];
+  double m2[2];
+} ct_ttest_t;
+
+static void ct_push (ct_ttest_t* t, uint8_t c, double x) {
+  double d;
+  t->n[c]++;
+  d = x - t->mean[c];
+  t->mean[c] += d / t->n[c];
+  t->m2[c] += d * (x - t->mean[c]);
+}
+
+static double ct_t (ct_ttest_t* t) {
+  double v0, v1;
+  if ((t->n[0]<2) || (t->n[1]<2)) return 0;
+  v0 = t->m2[0] / (t->n[0] - 1);
+  v1 = t->m2[1] / (t->n[1] - 1);
+  if (v0 + v1 == 0) return 0;
+  return (t->mean[0] - t->mean[1]) / __builtin_sqrt (v0 / t->n[0] + v1 / t->n[1]);
+}
+
+static int ct_cmp (const void* a, const void* b) {
+  uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+/* the fences drain the stores of the input set up, which differ between
+ * the classes, before the count is read */
+static inline uint64_t ct_clock (void) {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_mfence ();
+  _mm_lfence ();
+  return __rdtsc ();
+#else
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+#endif
+}
+
+class NorxCt {
+  public :
+    NorxCt (Norx* norx);
+    bool timing (uint32_t samples);
+    uint8_t taint (void);
+
+  private :
+    Norx* norx;
+    uint64_t rng;
+    uint8_t bits;
+    state_t s, r;
+    uint8_t key[32], nonce[16], t[NORX_MAX_TAG_SIZE], good[NORX_MAX_TAG_SIZE];
+    uint8_t m[64], c[64 + NORX_MAX_TAG_SIZE];
+    uint64_t* x;
+    uint8_t* cls;
+    double mean[2];
+    uint8_t fixed[sizeof(state64_t)];
+
+    void _random (uint8_t* p, size_t len);
+    void _input (uint8_t cls, uint8_t* p, size_t len);
+    void _state (uint8_t cls, state_t* s);
+    double _measure (uint32_t samples, void (NorxCt::*prep)(uint8_t), void (NorxCt::*op)(void));
+    bool _target (const char* name, uint32_t samples, void (NorxCt::*prep)(uint8_t), void (NorxCt::*op)(void));
+
+    // targets, prep sets up the class, op is the timed part
+    void _prep_state (uint8_t cls);
+    void _prep_compare (uint8_t cls);
+    void _prep_key (uint8_t cls);
+    void _prep_verify (uint8_t cls);
+    void _prep_message (uint8_t cls);
+    void _G (void);
+    void _permute (void);
+    void _compare (void);
+    void _start (void);
+    void _verify (void);
+    void _encrypt (void);
+    void _decrypt (void);
+};
+
+NorxCt::NorxCt (Norx* norx) {
+  this->norx = norx;
+  this->rng = (uint64_t)time (NULL) * 0x9e3779b97f4a7c15ULL | 1;
+  this->bits = 32;
+  memset (&(this->s), 0, sizeof(this->s));
+  memset (&(this->r), 0, sizeof(this->r));
+  memset (this->key, 0, sizeof(this->key));
+  memset (this->nonce, 0, sizeof(this->nonce));
+  memset (this->t, 0, sizeof(this->t));
+  memset (this->good, 0, sizeof(this->good));
+  memset (this->m, 0, sizeof(this->m));
+  memset (this->c, 0, sizeof(this->c));
+  this->x = NULL;
+  this->cls = NULL;
+  this->mean[0] = this->mean[1] = 0;
+  this->_random (this->fixed, sizeof(this->fixed));
+}
+
+/* xorshift64*, only has to be unpredictable to the code under test */
+void NorxCt::_random (uint8_t* p, size_t len) {
+  size_t i;
+  for (i=0;i<len;i++) {
+    this->rng ^= this->rng >> 12;
+    this->rng ^= this->rng << 25;
+    this->rng ^= this->rng >> 27;
+    p[i] = (this->rng * 0x2545f4914f6cdd1dULL) >> 56;
+  }
+}
+
+/* class 0 is one fixed pattern (not zero, some cores store zero faster),
+ * class 1 random. both are copied the same way, so that the stores in
+ * front of the timed op do not differ */
+void NorxCt::_input (uint8_t cls, uint8_t* p, size_t len) {
+  uint8_t v[2][sizeof(state64_t)];
+  memcpy (v[0], this->fixed, len);
+  this->_random (v[1], len);
+  memcpy (p, v[cls], len);
+}
+
+void NorxCt::_state (uint8_t cls, state_t* s) {
+  s->bits = this->bits;
+  s->rounds = 4;
+  this->_input (cls, (uint8_t*)&(s->s32), (this->bits==32) ? sizeof(state32_t) : sizeof(s->s32) * 2);
+}
+
+void NorxCt::_prep_state (uint8_t cls) {
+  this->_state (cls, &(this->s));
+}
+
+/* equal states, or states differing in their first byte */
+void NorxCt::_prep_compare (uint8_t cls) {
+  this->_state (1, &(this->s));
+  this->norx->copy_state (&(this->s), &(this->r));
+  ((uint8_t*)&(this->r.s32))[0] ^= cls;
+}
+
+void NorxCt::_prep_key (uint8_t cls) {
+  this->_input (cls, this->key, sizeof(this->key));
+}
+
+/* the right tag, or a random one, for an empty message under a fixed key */
+void NorxCt::_prep_verify (uint8_t cls) {
+  uint8_t v[2][NORX_MAX_TAG_SIZE];
+  memcpy (v[0], this->good, sizeof(this->t));
+  this->_random (v[1], sizeof(this->t));
+  this->norx->start (this->bits, this->key, this->nonce);
+  memcpy (this->t, v[cls], sizeof(this->t));
+}
+
+void NorxCt::_prep_message (uint8_t cls) {
+  this->_input (cls, this->m, sizeof(this->m));
+  this->_input (cls, this->key, sizeof(this->key));
+}
+
+void NorxCt::_G (void) {
+  this->norx->_G (&(this->s), 0, 4, 8, 12);
+}
+
+void NorxCt::_permute (void) {
+  this->norx->_permute (&(this->s), 4);
+}
+
+void NorxCt::_compare (void) {
+  volatile bool b = this->norx->compare_state (&(this->s), &(this->r));
+  (void)b;
+}
+
+void NorxCt::_start (void) {
+  this->norx->start (this->bits, this->key, this->nonce);
+}
+
+void NorxCt::_verify (void) {
+  volatile bool b = this->norx->verify (this->t);
+  (void)b;
+}
+
+void NorxCt::_encrypt (void) {
+  this->norx->encrypt (this->bits, this->key, this->nonce, NULL, 0,
+                       this->m, sizeof(this->m), NULL, 0, this->c);
+}
+
+/* the ciphertext is the message itself, the tag never matches */
+void NorxCt::_decrypt (void) {
+  volatile bool b;
+  memcpy (this->c, this->m, sizeof(this->m));
+  b = this->norx->decrypt (this->bits, this->key, this->nonce, NULL, 0,
+                           this->c, sizeof(this->m) + this->norx->tag_size (), NULL, 0, this->c);
+  (void)b;
+}
+
+/* largest |t| over the raw and the cropped measurements */
+double NorxCt::_measure (uint32_t samples,
+                         void (NorxCt::*prep)(uint8_t), void (NorxCt::*op)(void)) {
+  ct_ttest_t tt[1 + CT_CROPS];
+  uint64_t crop[CT_CROPS], c0, c1;
+  uint64_t* sorted;
+  double t, max = 0;
+  uint32_t i;
+  uint8_t j;
+
+  memset (tt, 0, sizeof(tt));
+  this->_random (this->cls, samples);
+  for (i=0;i<samples;i++) {
+    this->cls[i] &= 1;
+    (this->*prep) (this->cls[i]);
+    c0 = ct_clock ();
+    (this->*op) ();
+    c1 = ct_clock ();
+    this->x[i] = c1 - c0;
+  }
+
+  // cropping thresholds, over everything measured
+  sorted = (uint64_t*)malloc (samples * sizeof(uint64_t));
+  memcpy (sorted, this->x, samples * sizeof(uint64_t));
+  qsort (sorted, samples, sizeof(uint64_t), ct_cmp);
+  for (j=0;j<CT_CROPS;j++)
+    crop[j] = sorted[((samples - 1) * (uint64_t)CT_PERCENTILES[j]) / 100];
+  free (sorted);
+
+  // the first tenth warms the caches up and is left out
+  for (i=samples/10;i<samples;i++) {
+    ct_push (&(tt[0]), this->cls[i], (double)this->x[i]);
+    for (j=0;j<CT_CROPS;j++)
+      if (this->x[i] <= crop[j]) ct_push (&(tt[1 + j]), this->cls[i], (double)this->x[i]);
+  }
+  this->mean[0] = tt[0].mean[0];
+  this->mean[1] = tt[0].mean[1];
+  for (j=0;j<=CT_CROPS;j++) {
+    t = ct_t (&(tt[j]));
+    if (t < 0) t = -t;
+    if (t > max) max = t;
+  }
+  return max;
+}
+
+bool NorxCt::_target (const char* name, uint32_t samples,
+                      void (NorxCt::*prep)(uint8_t), void (NorxCt::*op)(void)) {
+  double t, max = 0;
+  uint8_t i;
+  for (i=0;i<CT_TRIES;i++) {
+    t = this->_measure (samples, prep, op);
+    if ((i==0) || (t < max)) max = t;
+    if (max <= CT_T_FAIL) break;
+  }
+
+  Serial.print (name);
+  Serial.print ("\t");
+  Serial.print (this->bits);
+  Serial.print ("\t");
+  Serial.print (this->mean[0], 1);
+  Serial.print ("\t");
+  Serial.print (this->mean[1], 1);
+  Serial.print ("\t");
+  Serial.print (max, 2);
+  Serial.print ("\t");
+  if (max > CT_T_FAIL) Serial.println ("LEAK");
+  else if (max > CT_T_WARN) Serial.println ("maybe");
+  else Serial.println ("ok");
+  return max <= CT_T_FAIL;
+}
+
+bool NorxCt::timing (uint32_t samples) {
+  bool ok = 1;
+  uint8_t w;
+
+  this->x = (uint64_t*)malloc (samples * sizeof(uint64_t));
+  this->cls = (uint8_t*)malloc (samples);
+  Serial.println ("target\tbits\tfixed\trandom\t|t|\tverdict");
+  for (w=32;w<=NORX_MAX_BITS;w+=32) {
+    this->bits = w;
+    memset (this->key, 0, sizeof(this->key));
+    this->norx->start (w, this->key, this->nonce);
+    this->norx->tag (this->good);
+    ok &= this->_target ("G", samples, &NorxCt::_prep_state, &NorxCt::_G);
+    ok &= this->_target ("F^4", samples, &NorxCt::_prep_state, &NorxCt::_permute);
+    ok &= this->_target ("compare_state", samples, &NorxCt::_prep_compare, &NorxCt::_compare);
+    ok &= this->_target ("start", samples, &NorxCt::_prep_key, &NorxCt::_start);
+    ok &= this->_target ("verify", samples, &NorxCt::_prep_verify, &NorxCt::_verify);
+    ok &= this->_target ("encrypt 64", samples, &NorxCt::_prep_message, &NorxCt::_encrypt);
+    ok &= this->_target ("decrypt 64", samples, &NorxCt::_prep_message, &NorxCt::_decrypt);
+  }
+  free (this->x);
+  free (this->cls);
+  return ok;
+}
+
+/* memcheck does the checking, this only has to run the secret paths */
+uint8_t NorxCt::taint (void) {
+#if NORX_CTGRIND
+  norx_key_t ctx;
+  uint8_t w, d;
+  bool b;
+
+  for (w=32;w<=NORX_MAX_BITS;w+=32) {
+    this->bits = w;
+    for (d=1;d<=2;d++) {
+      this->norx->begin (4, d);
+      this->_random (this->key, sizeof(this->key));
+      this->_random (this->nonce, sizeof(this->nonce));
+      this->_random (this->m, sizeof(this->m));
+      NORX_CT_SECRET (this->key, sizeof(this->key));
+      NORX_CT_SECRET (this->m, sizeof(this->m));
+
+      this->_encrypt ();
+      b = this->norx->decrypt (w, this->key, this->nonce, NULL, 0,
+                               this->c, sizeof(this->m) + this->norx->tag_size (), NULL, 0, this->c);
+      if (!b) Serial.println ("taint: decrypt failed");
+
+      this->norx->prepare (&ctx, w, this->key);
+      this->norx->start (&ctx, this->nonce);
+      this->norx->encrypt (this->m, this->c, sizeof(this->m));
+      this->norx->tag (this->t);
+      this->_random (this->t, sizeof(this->t));
+      this->norx->start (&ctx, this->nonce);
+      this->norx->decrypt (this->c, this->m, sizeof(this->m));
+      b = this->norx->verify (this->t);
+      this->norx->wipe (&ctx);
+    }
+    this->_state (1, &(this->s));
+    NORX_CT_SECRET (&(this->s.s32), (w==32) ? sizeof(state32_t) : sizeof(this->s.s32) * 2);
+    this->norx->copy_state (&(this->s), &(this->r));
+    this->_G ();
+    this->norx->_G_ref (&(this->r), 0, 4, 8, 12);
+    this->_permute ();
+    this->norx->_F_ref (&(this->r));
+    b = this->norx->compare_state (&(this->s), &(this->r));
+    (void)b;
+  }
+  Serial.println ("taint run done, see the memcheck report");
+  return 0;
+#else
+  Serial.println ("norxct: built without NORX_CTGRIND, nothing is marked secret");
+  return 2;
+#endif
+}
+
+Norx norx;
+NorxCt ct (&norx);
+
+int main (int argc, char** argv) {
+  uint32_t samples = CT_SAMPLES;
+  Serial.begin (9600);
+  norx.begin (4, 1);
+  if ((argc>1) && !strcmp (argv[1], "taint"))
+    return ct.taint ();
+  if (argc>1) samples = strtoul (argv[1], NULL, 10);
+  if (samples < 1000) samples = 1000;
+  return ct.timing (samples) ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+#include "fuzz.h"
+#include "norx_batch.h"
+
+/***************************************************************************
+ * the AEAD entry points against each other
+ *
+ * one shot encrypt is the reference, then the same message goes through
+ *   streaming, in chunks of random sizes
+ *   the segment API, in place
+ *   a keyed context
+ *   save, restore in a second instance, and the end of the stream there
+ *   the batch engine (D=1), next to two shorter messages
+ * and comes back through one shot decrypt, which must refuse a forged tag
+ *
+ * input : width and rounds, D, the seed of the chunk sizes, header and
+ * trailer lengths, key and nonce, then the header, trailer and message
+ */
+
+#define FUZZ_MSG (FUZZ_MAX + NORX_MAX_TAG_SIZE)
+
+static Norx norx, other;
+#if NORX_BATCH
+static NorxBatch batch (&norx);
+#endif
+static uint8_t h[256], t[256], m[FUZZ_MSG], c[FUZZ_MSG], x[FUZZ_MSG];
+static uint8_t blob[NORX_SAVE_MAX];
+#if NORX_BATCH
+static uint8_t bout[3][FUZZ_MSG];
+#endif
+
+/* xorshift32 for the chunk sizes, 1 to 2 blocks, a whole block now and then */
+static size_t fuzz_chunk (uint32_t* rng, uint8_t rate) {
+  *rng ^= *rng << 13;
+  *rng ^= *rng >> 17;
+  *rng ^= *rng << 5;
+  if ((*rng & 7)==0) return rate;
+  return 1 + (*rng >> 8) % (2*rate);
+}
+
+static void fuzz_stream (Norx* n, uint8_t* out, const uint8_t* in, size_t len, uint32_t* rng, uint8_t rate) {
+  size_t i, k;
+  for (i=0;i<len;i+=k) {
+    k = fuzz_chunk (rng, rate);
+    if (k > len - i) k = len - i;
+    n->encrypt (out + i, in + i, k);
+  }
+}
+
+extern "C" int LLVMFuzzerTestOneInput (const uint8_t* data, size_t size) {
+  fuzz_in_t in = { data, size };
+  uint8_t key[32], nonce[16], tag[NORX_MAX_TAG_SIZE];
+  uint8_t f, r, d, bits, wb, rate, tlen;
+  uint32_t rng;
+  size_t hlen, ttlen, mlen, i, k, blen;
+  norx_seg_t hs[2], ms[3], ts[1];
+  norx_key_t ctx;
+
+  fuzz_data = data;
+  fuzz_size = size;
+  f = fuzz_byte (&in);
+  bits = (f & 1) ? 64 : 32;
+  if (bits > NORX_MAX_BITS) return 0;
+  r = 1 + ((f >> 1) & 7);
+  d = fuzz_byte (&in) % (NORX_MAX_LANES + 1);
+  rng = 0x9e3779b9 ^ fuzz_byte (&in);
+  hlen = fuzz_byte (&in);
+  ttlen = fuzz_byte (&in);
+  wb = bits >> 3;
+  rate = 10 * wb;
+  tlen = bits >> 1;
+  fuzz_bytes (&in, key, 4*wb);
+  fuzz_bytes (&in, nonce, 2*wb);
+  fuzz_bytes (&in, h, hlen);
+  fuzz_bytes (&in, t, ttlen);
+  mlen = (in.len > FUZZ_MAX) ? FUZZ_MAX : in.len;
+  fuzz_bytes (&in, m, mlen);
+  NorxFuzz::setup (&norx, r, d);
+
+  // the reference
+  norx.encrypt (bits, key, nonce, h, hlen, m, mlen, t, ttlen, c);
+
+  // streaming, every phase in chunks
+  norx.start (bits, key, nonce);
+  for (i=0;i<hlen;i+=k) {
+    k = fuzz_chunk (&rng, rate);
+    if (k > hlen - i) k = hlen - i;
+    norx.header (h + i, k);
+  }
+  fuzz_stream (&norx, x, m, mlen, &rng, rate);
+  norx.trailer (t, ttlen);
+  norx.tag (x + mlen);
+  FUZZ_CHECK (!memcmp (c, x, mlen + tlen), "streaming");
+
+  // segments, in place
+  memcpy (x, m, mlen);
+  k = mlen ? (rng % (mlen + 1)) : 0;
+  i = k + ((mlen - k) >> 1);
+  ms[0].p = x;     ms[0].len = k;
+  ms[1].p = x + k; ms[1].len = i - k;
+  ms[2].p = x + i; ms[2].len = mlen - i;
+  hs[0].p = h;     hs[0].len = hlen >> 1;
+  hs[1].p = h + (hlen >> 1); hs[1].len = hlen - (hlen >> 1);
+  ts[0].p = t;     ts[0].len = ttlen;
+  norx.start (bits, key, nonce);
+  norx.header (hs, 2);
+  norx.encrypt (ms, 3);
+  norx.trailer (ts, 1);
+  norx.tag (tag);
+  FUZZ_CHECK (!memcmp (c, x, mlen) && !memcmp (c + mlen, tag, tlen), "segments");
+
+  // keyed context
+  norx.prepare (&ctx, bits, key);
+  norx.encrypt (&ctx, nonce, h, hlen, m, mlen, t, ttlen, x);
+  norx.wipe (&ctx);
+  FUZZ_CHECK (!memcmp (c, x, mlen + tlen), "keyed context");
+
+  // save mid payload, finish in the other instance
+  k = mlen ? (rng % (mlen + 1)) : 0;
+  norx.start (bits, key, nonce);
+  norx.header (h, hlen);
+  fuzz_stream (&norx, x, m, k, &rng, rate);
+  blen = norx.save (blob);
+  FUZZ_CHECK (other.restore (blob, blen)==NORX_RESTORE_OK, "restore");
+  fuzz_stream (&other, x + k, m + k, mlen - k, &rng, rate);
+  other.trailer (t, ttlen);
+  other.tag (x + mlen);
+  FUZZ_CHECK (!memcmp (c, x, mlen + tlen), "save and restore");
+
+#if NORX_BATCH
+  // the batch engine, with two shorter messages in the other lanes
+  if (d==1) {
+    norx_job_t jobs[3];
+    for (i=0;i<3;i++) {
+      jobs[i].key = key;
+      jobs[i].nonce = nonce;
+      jobs[i].h = h;
+      jobs[i].hlen = hlen;
+      jobs[i].in = m;
+      jobs[i].out = bout[i];
+      jobs[i].len = mlen / (1 + i);
+      jobs[i].t = t;
+      jobs[i].tlen = ttlen;
+      jobs[i].tag = bout[i] + jobs[i].len;
+    }
+    FUZZ_CHECK (batch.encrypt (bits, jobs, 3), "batch");
+    for (i=0;i<3;i++) {
+      norx.encrypt (bits, key, nonce, h, hlen, m, jobs[i].len, t, ttlen, x);
+      FUZZ_CHECK (!memcmp (bout[i], x, jobs[i].len + tlen), "batch");
+    }
+  }
+#endif
+
+  // back, and a forged tag
+  FUZZ_CHECK (norx.decrypt (bits, key, nonce, h, hlen, c, mlen + tlen, t, ttlen, x), "decrypt");
+  FUZZ_CHECK (!memcmp (m, x, mlen), "decrypted message");
+  c[mlen + (rng % tlen)] ^= 1 << ((rng >> 8) & 7);
+  FUZZ_CHECK (!norx.decrypt (bits, key, nonce, h, hlen, c, mlen + tlen, t, ttlen, x), "forged tag");
+  return 0;
+}
+
+/* keys and nonces from the F test vectors, the header, trailer and message
+   of _test_aead, its lengths and five blocks more, D 1, 2 and 0 */
+size_t norx_fuzz_seed (uint32_t i, uint8_t* buf, size_t max) {
+  const uint8_t D[] = { 1, 2, 0 };
+  state_t s;
+  uint8_t bits, rate, wb, j = i % 24, v = i / 24;
+  size_t n, k, len, lens[4];
+
+  bits = (j & 1) ? 64 : 32;
+  if (bits > NORX_MAX_BITS) bits = 32;
+  if (!NorxFuzz::vector (&norx, bits, v, &s)) return 0;
+  wb = bits >> 3;
+  rate = 10 * wb;
+  lens[0] = 0; lens[1] = rate - 1; lens[2] = rate; lens[3] = rate + 1;
+  len = lens[(j >> 1) & 3] + ((v & 1) ? 5*rate : 0);
+  n = 5 + 6*wb + 11 + 7 + len;
+  if (n > max) return 0;
+  buf[0] = ((bits==64) ? 1 : 0) | (3 << 1);
+  buf[1] = D[j >> 3];
+  buf[2] = i;
+  buf[3] = 11;
+  buf[4] = 7;
+  memcpy (buf + 5, &(s.s32), 6*wb);
+  memcpy (buf + 5 + 6*wb, "norx header", 11);
+  memcpy (buf + 5 + 6*wb + 11, "trailer", 7);
+  for (k=0;k<len;k++) buf[5 + 6*wb + 18 + k] = k * 7;
+  return n;
+}
@@ -0,0 +1,83 @@
+#ifndef __norx_fuzz_h_
+#define __norx_fuzz_h_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Arduino.h"
+#include "norx.h"
+
+/***************************************************************************
+ * differential fuzz targets, host only
+ *
+ * every target (*_fuzzer.cpp) runs one input through each implementation it
+ * knows of and aborts as soon as two of them disagree. a target defines
+ *   LLVMFuzzerTestOneInput   the libFuzzer entry point
+ *   norx_fuzz_seed           seed input i, built from the PROGMEM vectors
+ * and is linked either with libFuzzer (clang -fsanitize=fuzzer) or with
+ * main.cpp, the standalone driver : replay of files, random inputs and
+ * writing of the seed corpus. see make fuzz
+ */
+
+#define FUZZ_MAX 4096
+
+extern "C" int LLVMFuzzerTestOneInput (const uint8_t* data, size_t size);
+size_t norx_fuzz_seed (uint32_t i, uint8_t* buf, size_t max);
+
+// the input being run, for the report
+static const uint8_t* fuzz_data;
+static size_t fuzz_size;
+
+static inline void fuzz_fail (const char* what) {
+  size_t i;
+  fprintf (stderr, "divergence : %s\ninput (%zu bytes) :", what, fuzz_size);
+  for (i=0;i<fuzz_size;i++) fprintf (stderr, "%s%02x", (i%32) ? "" : "\n  ", fuzz_data[i]);
+  fprintf (stderr, "\n");
+  abort ();
+}
+
+#define FUZZ_CHECK(c, what) do { if (!(c)) fuzz_fail (what); } while (0)
+
+// the input is read front to back, zeros once it runs out
+typedef struct {
+  const uint8_t* p;
+  size_t len;
+} fuzz_in_t;
+
+static inline uint8_t fuzz_byte (fuzz_in_t* in) {
+  if (!in->len) return 0;
+  in->len--;
+  return *(in->p++);
+}
+
+static inline void fuzz_bytes (fuzz_in_t* in, uint8_t* d, size_t n) {
+  while (n--) *(d++) = fuzz_byte (in);
+}
+
+/* the Norx internals the targets compare */
+class NorxFuzz {
+  public :
+    static void F_ref (Norx* n, state_t* s) { n->_F_ref (s); }
+    static void G_ref (Norx* n, state_t* s, uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+      n->_G_ref (s, a, b, c, d);
+    }
+    static void G (Norx* n, state_t* s, uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+      n->_G (s, a, b, c, d);
+    }
+    static void permute (Norx* n, state_t* s, uint8_t r) { n->_permute (s, r); }
+    // the F test vectors, none without NORX_DIAG
+    static bool vector (Norx* n, uint8_t bits, uint8_t i, state_t* s) {
+#if NORX_DIAG
+      return n->_test_vector (bits, i, s);
+#else
+      return 0;
+#endif
+    }
+    // begin without its banner, d must be valid
+    static void setup (Norx* n, uint8_t r, uint8_t d) {
+      n->rounds = r;
+      n->d = d;
+    }
+};
+
+#endif
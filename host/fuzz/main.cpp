@@ -0,0 +1,116 @@
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "fuzz.h"
+
+/***************************************************************************
+ * standalone driver for the fuzz targets, when libFuzzer is not there
+ *
+ *   norxfuzz_<target> [-n runs] [-s seed] [file|dir ...]
+ *       replays the files, and those of the directories, then runs the
+ *       seeds and the given number of random inputs (default 10000), half
+ *       of them mutated seeds
+ *   norxfuzz_<target> -w dir
+ *       writes the seed corpus to dir, to start libFuzzer from
+ *
+ * a divergence aborts, after printing the input
+ */
+
+#define FUZZ_RUNS 10000
+
+static uint8_t buf[FUZZ_MAX + 512];
+static uint64_t rng;
+
+static uint32_t fuzz_random (void) {
+  rng ^= rng >> 12;
+  rng ^= rng << 25;
+  rng ^= rng >> 27;
+  return (rng * 0x2545f4914f6cdd1dULL) >> 32;
+}
+
+static size_t fuzz_read (const char* path) {
+  FILE* f = fopen (path, "rb");
+  size_t n;
+  if (!f) {
+    fprintf (stderr, "%s: cannot open\n", path);
+    exit (2);
+  }
+  n = fread (buf, 1, sizeof(buf), f);
+  fclose (f);
+  return n;
+}
+
+static unsigned long fuzz_replay (const char* path) {
+  struct stat st;
+  struct dirent* e;
+  DIR* dir;
+  char name[1024];
+  unsigned long n = 0;
+
+  if (stat (path, &st) || !S_ISDIR (st.st_mode)) {
+    LLVMFuzzerTestOneInput (buf, fuzz_read (path));
+    return 1;
+  }
+  dir = opendir (path);
+  while (dir && (e = readdir (dir))) {
+    if (e->d_name[0]=='.') continue;
+    snprintf (name, sizeof(name), "%s/%s", path, e->d_name);
+    n += fuzz_replay (name);
+  }
+  if (dir) closedir (dir);
+  return n;
+}
+
+static int fuzz_write (const char* dir) {
+  char name[1024];
+  uint32_t i;
+  size_t n;
+  FILE* f;
+  mkdir (dir, 0755);
+  for (i=0;(n = norx_fuzz_seed (i, buf, sizeof(buf)));i++) {
+    snprintf (name, sizeof(name), "%s/seed-%04u", dir, i);
+    f = fopen (name, "wb");
+    if (!f || (fwrite (buf, 1, n, f)!=n)) {
+      fprintf (stderr, "%s: cannot write\n", name);
+      return 2;
+    }
+    fclose (f);
+  }
+  printf ("%u seeds in %s\n", i, dir);
+  return 0;
+}
+
+int main (int argc, char** argv) {
+  unsigned long runs = FUZZ_RUNS, n = 0, i;
+  uint32_t seeds, k;
+  size_t len;
+  int a;
+
+  Serial.begin (9600);
+  rng = (uint64_t)time (NULL) | 1;
+  for (a=1;a<argc;a++) {
+    if (!strcmp (argv[a], "-w") && (a+1<argc)) return fuzz_write (argv[a+1]);
+    if (!strcmp (argv[a], "-n") && (a+1<argc)) { runs = strtoul (argv[++a], NULL, 10); continue; }
+    if (!strcmp (argv[a], "-s") && (a+1<argc)) { rng = strtoull (argv[++a], NULL, 0) | 1; continue; }
+    n += fuzz_replay (argv[a]);
+  }
+  printf ("seed %llu\n", (unsigned long long)rng);
+
+  for (seeds=0;(len = norx_fuzz_seed (seeds, buf, sizeof(buf)));seeds++, n++)
+    LLVMFuzzerTestOneInput (buf, len);
+
+  for (i=0;i<runs;i++, n++) {
+    if (seeds && (fuzz_random () & 1)) {
+      len = norx_fuzz_seed (fuzz_random () % seeds, buf, sizeof(buf));
+      for (k=fuzz_random () % 4;k<4;k++)
+        buf[fuzz_random () % len] ^= 1 << (fuzz_random () & 7);
+      if (fuzz_random () & 1) len = fuzz_random () % (len + 1);
+    } else {
+      len = fuzz_random () % 600;
+      for (k=0;k<len;k++) buf[k] = fuzz_random ();
+    }
+    LLVMFuzzerTestOneInput (buf, len);
+  }
+  printf ("%lu inputs, no divergence\n", n);
+  return 0;
+}
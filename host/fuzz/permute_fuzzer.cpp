@@ -0,0 +1,109 @@
+#include "fuzz.h"
+#include "norx_core.h"
+#include "norx_simd.h"
+
+/***************************************************************************
+ * G and F^R, every kernel against the reference __G_32 / __G_64
+ *
+ * input : one byte of flags, bit 0 the width (NORX32 / NORX64), bits 1 to
+ * 3 the rounds less one, then the sixteen state words little endian
+ */
+
+static Norx norx;
+
+template <typename W>
+static void fuzz_core (const state_t* s, uint8_t r, const state_t* e, size_t len) {
+  state_t x;
+  uint8_t i;
+
+  // one round at a time
+  memcpy (&x, s, sizeof(state_t));
+  for (i=0;i<r;i++) NorxCore<W, 1>::permute ((W*)&(x.s32));
+  FUZZ_CHECK (!memcmp (&(x.s32), &(e->s32), len), "NorxCore<W, 1>");
+
+  // unrolled, as _permute uses them
+  memcpy (&x, s, sizeof(state_t));
+  if (r==4) NorxCore<W, 4>::permute ((W*)&(x.s32));
+  if (r==6) NorxCore<W, 6>::permute ((W*)&(x.s32));
+  if ((r==4)||(r==6)) FUZZ_CHECK (!memcmp (&(x.s32), &(e->s32), len), "NorxCore<W, R>");
+}
+
+extern "C" int LLVMFuzzerTestOneInput (const uint8_t* data, size_t size) {
+  fuzz_in_t in = { data, size };
+  state_t s, e, x;
+  uint8_t f, r, i, bits, wb;
+  size_t len;
+
+  fuzz_data = data;
+  fuzz_size = size;
+  f = fuzz_byte (&in);
+  bits = (f & 1) ? 64 : 32;
+  if (bits > NORX_MAX_BITS) return 0;
+  r = 1 + ((f >> 1) & 7);
+  wb = bits >> 3;
+  len = 16 * wb;
+
+  memset (&s, 0, sizeof(s));
+  s.bits = bits;
+  s.rounds = r;
+  fuzz_bytes (&in, (uint8_t*)&(s.s32), len);
+
+  // G, on a column and on a diagonal
+  memcpy (&e, &s, sizeof(s));
+  memcpy (&x, &s, sizeof(s));
+  NorxFuzz::G_ref (&norx, &e, 0, 4, 8, 12);
+  NorxFuzz::G_ref (&norx, &e, 3, 4, 9, 14);
+  NorxFuzz::G (&norx, &x, 0, 4, 8, 12);
+  NorxFuzz::G (&norx, &x, 3, 4, 9, 14);
+  FUZZ_CHECK (!memcmp (&(x.s32), &(e.s32), len), "_G");
+
+  // the reference F^R
+  memcpy (&e, &s, sizeof(s));
+  for (i=0;i<r;i++) NorxFuzz::F_ref (&norx, &e);
+
+  // the dispatch, SIMD when the host has it
+  memcpy (&x, &s, sizeof(s));
+  NorxFuzz::permute (&norx, &x, r);
+  FUZZ_CHECK (!memcmp (&(x.s32), &(e.s32), len), "_permute");
+
+  // the scalar core, whatever the dispatch picked
+  if (bits==32) fuzz_core<uint32_t> (&s, r, &e, len);
+#if NORX_64
+  if (bits==64) fuzz_core<uint64_t> (&s, r, &e, len);
+#endif
+
+#if NORX_SIMD
+  memcpy (&x, &s, sizeof(s));
+  if (norx_simd_permute (&x, r))
+    FUZZ_CHECK (!memcmp (&(x.s32), &(e.s32), len), norx_simd_name (bits));
+#endif
+  return 0;
+}
+
+/* the F test vectors, at every round count */
+size_t norx_fuzz_seed (uint32_t i, uint8_t* buf, size_t max) {
+  state_t s;
+  uint8_t bits, r, wb, j, k;
+  uint32_t n;
+  uint64_t w;
+
+  for (bits=32;bits<=NORX_MAX_BITS;bits+=32) {
+    for (n=0;NorxFuzz::vector (&norx, bits, n, &s);n++);
+    if (i < 8*n) break;
+    i -= 8*n;
+  }
+  if (bits > NORX_MAX_BITS) return 0;
+  NorxFuzz::vector (&norx, bits, i >> 3, &s);
+  r = 1 + (i & 7);
+  wb = bits >> 3;
+  if (max < 1 + 16u*wb) return 0;
+  buf[0] = ((bits==64) ? 1 : 0) | ((r - 1) << 1);
+  for (j=0;j<16;j++) {
+    w = s.s32.w[j];
+#if NORX_64
+    if (bits==64) w = s.s64.w[j];
+#endif
+    for (k=0;k<wb;k++) buf[1 + j*wb + k] = w >> (8*k);
+  }
+  return 1 + 16*wb;
+}
@@ -0,0 +1,329 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Arduino.h"
+#include "norx.h"
+#include "cryptoutils.h"
+
+/***************************************************************************
+ * known answer test runner, host only
+ *
+ *   norxkat file...
+ *
+ * the files hold one vector per paragraph, CAESAR style, as written by
+ * kat/genkat.py :
+ *
+ *   W = 32              W, R and D hold until changed
+ *   R = 4
+ *   D = 1
+ *   Count = 1
+ *   Key = ...           hex, 4 words (NORX8 10 bytes, NORX16 12)
+ *   Nonce = ...         hex, 2 words (NORX8 and NORX16 4 bytes)
+ *   AD = ...            the header
+ *   PT = ...
+ *   Trailer = ...       may be left out
+ *   CT = ...            ciphertext then tag
+ *   S_Init = ...        optional, the state after init and after each non
+ *   S_Header = ...      empty phase, 16 little endian words. they are only
+ *   S_Payload = ...     checked with a TRACE=1 build, the states come from
+ *   S_Trailer = ...     the trace sink
+ *   S_Final = ...
+ *
+ * every vector is encrypted through the streaming API, then decrypted one
+ * shot and decrypted again with a forged tag. a mismatch names the phase:
+ * the first wrong state when there are states, otherwise the payload block
+ * holding the first wrong ciphertext byte, or the tag
+ */
+
+// init, header, payload, trailer, final
+#define KAT_STATES  5
+
+const char* KAT_PHASES[KAT_STATES] = { "init", "header", "payload", "trailer", "final" };
+const char* KAT_FIELDS[KAT_STATES] = { "S_Init", "S_Header", "S_Payload", "S_Trailer", "S_Final" };
+// trace labels, see norx.cpp
+const char* KAT_LABELS[KAT_STATES] = { "init  ", "header", "payld ", "trail ", "final " };
+
+typedef struct {
+  uint8_t* p;
+  size_t len;
+  size_t cap;
+} kat_buf_t;
+
+// the states seen by the trace sink, for the vector being run
+static state_t kat_trace[KAT_STATES];
+static uint8_t kat_traced;
+
+static void kat_sink (state_t* s, char* label) {
+  uint8_t i;
+  for (i=0;i<KAT_STATES;i++)
+    if (!strcmp (label, KAT_LABELS[i])) {
+      memcpy (&(kat_trace[i]), s, sizeof(state_t));
+      kat_traced |= 1 << i;
+    }
+}
+
+/* hex to b, false on an odd length or a bad digit */
+static bool kat_hex (kat_buf_t* b, const char* hex) {
+  size_t len = strlen (hex);
+  if (len/2 > b->cap) {
+    b->cap = len/2;
+    b->p = (uint8_t*)realloc (b->p, b->cap);
+  }
+  return (hex_decode (b->p, b->cap, hex, len, &(b->len))==HEX_OK);
+}
+
+class NorxKat {
+  public :
+    NorxKat (Norx* norx);
+    bool run (const char* path);
+
+  private :
+    Norx* norx;
+    const char* path;
+    unsigned long line, at, count;
+    unsigned long vectors, failed, skipped;
+    uint8_t bits, rounds, d;
+    bool open;
+    uint8_t have;
+    kat_buf_t key, nonce, h, m, t, c, out, states[KAT_STATES];
+
+    void _reset (void);
+    bool _field (const char* name, const char* value);
+    void _fail (const char* what, const char* name = NULL, long i = -1);
+    void _check (void);
+    bool _state (uint8_t i);
+};
+
+NorxKat::NorxKat (Norx* norx) {
+  this->norx = norx;
+  kat_buf_t* b[] = { &(this->key), &(this->nonce), &(this->h), &(this->m), &(this->t),
+                     &(this->c), &(this->out) };
+  uint8_t i;
+  for (i=0;i<sizeof(b)/sizeof(b[0]);i++) memset (b[i], 0, sizeof(kat_buf_t));
+  memset (this->states, 0, sizeof(this->states));
+  this->bits = 32;
+  this->rounds = 4;
+  this->d = 1;
+}
+
+void NorxKat::_reset (void) {
+  uint8_t i;
+  this->open = 0;
+  this->have = 0;
+  this->key.len = this->nonce.len = 0;
+  this->h.len = this->m.len = this->t.len = this->c.len = 0;
+  for (i=0;i<KAT_STATES;i++) this->states[i].len = 0;
+}
+
+void NorxKat::_fail (const char* what, const char* name, long i) {
+  if (!this->failed++) Serial.println ();
+  Serial.print (this->path);
+  Serial.print (":");
+  Serial.print (this->at);
+  Serial.print (": Count ");
+  Serial.print (this->count);
+  Serial.print (" W ");
+  Serial.print (this->bits);
+  Serial.print (" R ");
+  Serial.print (this->rounds);
+  Serial.print (" D ");
+  Serial.print (this->d);
+  Serial.print (": ");
+  Serial.print (what);
+  if (name) Serial.print (name);
+  if (i>=0) Serial.print (i);
+  Serial.println ();
+}
+
+/* the traced state i against the file, both as little endian words */
+bool NorxKat::_state (uint8_t i) {
+  uint8_t b[sizeof(state64_t)];
+  uint8_t j, k, wb = this->bits >> 3;
+  uint64_t v;
+  for (j=0;j<16;j++) {
+    v = this->norx->_word (&(kat_trace[i]), j);
+    for (k=0;k<wb;k++) b[j*wb + k] = v >> (8*k);
+  }
+  return !memcmp (b, this->states[i].p, 16*wb);
+}
+
+void NorxKat::_check (void) {
+  uint8_t wb = this->bits >> 3, tlen = this->bits >> 1, rate = 10 * wb;
+  uint8_t klen = 4 * wb, nlen = 2 * wb;
+  size_t i, len = this->m.len;
+  uint8_t i8;
+
+  this->vectors++;
+  if (this->bits==8) {
+    klen = tlen = 10;
+    nlen = 4;
+    rate = 5;
+  } else if (this->bits==16) {
+    klen = tlen = 12;
+    nlen = 4;
+    rate = 16;
+  } else if ((this->bits!=32)&&(this->bits!=64)) {
+    return this->_fail ("bad W");
+  }
+  if ((this->bits > NORX_MAX_BITS)||(this->bits < NORX_MIN_BITS)) {
+    this->skipped++;
+    return;
+  }
+  if ((this->key.len!=klen)||(this->nonce.len!=nlen)||(this->c.len!=len+tlen))
+    return this->_fail ("malformed, key, nonce or CT length");
+  for (i8=0;i8<KAT_STATES;i8++)
+    if (this->states[i8].len && (this->states[i8].len!=16*(size_t)wb))
+      return this->_fail ("malformed, length of ", KAT_FIELDS[i8]);
+  if ((this->rounds!=this->norx->rounds)||(this->d!=this->norx->d))
+    if (!this->norx->begin (this->rounds, this->d)) return this->_fail ("R or D not supported");
+
+  if (this->out.cap < len + tlen) {
+    this->out.cap = len + tlen;
+    this->out.p = (uint8_t*)realloc (this->out.p, this->out.cap);
+  }
+
+  kat_traced = 0;
+  this->norx->start (this->bits, this->key.p, this->nonce.p);
+  this->norx->header (this->h.p, this->h.len);
+  this->norx->encrypt (this->out.p, this->m.p, len);
+  this->norx->trailer (this->t.p, this->t.len);
+  this->norx->tag (this->out.p + len);
+
+  // the first wrong state names the phase, when there are states
+  for (i8=0;i8<KAT_STATES;i8++)
+    if (this->states[i8].len && (kat_traced & (1 << i8)) && !this->_state (i8))
+      return this->_fail ("state after ", KAT_PHASES[i8]);
+  if (memcmp (this->out.p, this->c.p, len + tlen)) {
+    for (i=0;(i<len+tlen)&&(this->out.p[i]==this->c.p[i]);i++);
+    if (i<len) return this->_fail ("ciphertext, from payload block ", NULL, i / rate);
+    return this->_fail ("tag, trailer or final");
+  }
+
+  if (!this->norx->decrypt (this->bits, this->key.p, this->nonce.p, this->h.p, this->h.len,
+                            this->c.p, this->c.len, this->t.p, this->t.len, this->out.p) ||
+      memcmp (this->out.p, this->m.p, len))
+    return this->_fail ("decrypt");
+  this->c.p[len] ^= 0x01;
+  if (this->norx->decrypt (this->bits, this->key.p, this->nonce.p, this->h.p, this->h.len,
+                           this->c.p, this->c.len, this->t.p, this->t.len, this->out.p))
+    this->_fail ("forged tag accepted");
+  this->c.p[len] ^= 0x01;
+}
+
+bool NorxKat::_field (const char* name, const char* value) {
+  kat_buf_t* b = NULL;
+  uint8_t i;
+  if (!strcmp (name, "W")) { this->bits = atoi (value); return 1; }
+  if (!strcmp (name, "R")) { this->rounds = atoi (value); return 1; }
+  if (!strcmp (name, "D")) { this->d = atoi (value); return 1; }
+  if (!strcmp (name, "Count")) {
+    this->count = strtoul (value, NULL, 10);
+    this->at = this->line;
+    this->open = 1;
+    return 1;
+  }
+  if (!strcmp (name, "Key")) b = &(this->key);
+  if (!strcmp (name, "Nonce")) b = &(this->nonce);
+  if (!strcmp (name, "AD")) b = &(this->h);
+  if (!strcmp (name, "PT")) b = &(this->m);
+  if (!strcmp (name, "Trailer")) b = &(this->t);
+  if (!strcmp (name, "CT")) { b = &(this->c); this->have = 1; }
+  for (i=0;i<KAT_STATES;i++)
+    if (!strcmp (name, KAT_FIELDS[i])) b = &(this->states[i]);
+  if (!b) return 1;
+  return kat_hex (b, value);
+}
+
+bool NorxKat::run (const char* path) {
+  FILE* f = fopen (path, "r");
+  char* buf = NULL;
+  size_t cap = 0;
+  ssize_t n;
+  char *name, *value, *e;
+  bool states = 0;
+  uint8_t i;
+
+  if (!f) {
+    Serial.print (path);
+    Serial.println (": cannot open");
+    return 0;
+  }
+  this->path = path;
+  this->line = this->vectors = this->failed = this->skipped = 0;
+  this->_reset ();
+  this->norx->trace (kat_sink);
+
+  for (;;) {
+    n = getline (&buf, &cap, f);
+    if (n>=0) this->line++;
+    while ((n>0)&&((buf[n-1]=='\n')||(buf[n-1]=='\r')||(buf[n-1]==' '))) buf[--n] = 0;
+    // a blank line or the end of the file closes the vector
+    if ((n<=0)&&this->open) {
+      if (this->have) this->_check ();
+      else this->_fail ("no CT");
+      for (i=0;i<KAT_STATES;i++) states |= (this->states[i].len != 0);
+      this->_reset ();
+    }
+    if (n<0) break;
+    if ((n==0)||(buf[0]=='#')||(buf[0]=='[')) continue;
+
+    e = strchr (buf, '=');
+    if (!e) {
+      this->at = this->line;
+      this->_fail ("no '=' in line");
+      continue;
+    }
+    value = e + 1;
+    while (*value==' ') value++;
+    while ((e>buf)&&(e[-1]==' ')) e--;
+    *e = 0;
+    name = buf;
+    // Count opens a vector, a second one closes the previous
+    if (!strcmp (name, "Count") && this->open) {
+      if (this->have) this->_check ();
+      this->_reset ();
+    }
+    if (!this->_field (name, value)) {
+      this->at = this->line;
+      this->_fail ("bad hex in ", name);
+    }
+  }
+  free (buf);
+  fclose (f);
+  this->norx->trace (NULL);
+
+  Serial.print (path);
+  Serial.print (": ");
+  Serial.print (this->vectors);
+  Serial.print (" vectors, ");
+  Serial.print (this->failed);
+  Serial.print (" failed");
+  if (this->skipped) {
+    Serial.print (", ");
+    Serial.print (this->skipped);
+    Serial.print (" skipped (NORX_64=0 or NORX_SMALL=0)");
+  }
+  Serial.println ();
+#if NORX_TRACE_LEVEL < NORX_TRACE_SUMMARY
+  if (states) Serial.println ("  the S_* states were not checked, that needs make TRACE=1");
+#endif
+  (void)states;
+  return (this->failed==0);
+}
+
+Norx norx;
+NorxKat kat (&norx);
+
+int main (int argc, char** argv) {
+  bool ok = 1;
+  int i;
+  Serial.begin (9600);
+  if (argc<2) {
+    Serial.println ("usage : norxkat file...");
+    return 2;
+  }
+  norx.begin (4, 1);
+  for (i=1;i<argc;i++)
+    ok &= kat.run (argv[i]);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,269 @@
+#!/usr/bin/env python3
+# writes the NORX v1 known answer files read by norxkat (host/kat.cpp)
+#
+#   python3 genkat.py          norx8.txt to norx64.txt, here
+#   python3 genkat.py --post   the NORX_POST digests of norx.cpp
+#   python3 genkat.py --drbg   the known answers of NorxDrbg::test
+#
+# a plain model of the spec, sharing no code with the library : F is
+# written from the G of the paper, the payload lanes (D>1 or D=0) are
+# branched and merged as described there. the files are only as good as
+# this model, they were checked against the PROGMEM vectors of norx.cpp
+# (F, init) and against the AEAD of the library, which agree
+#
+# NORX8 and NORX16 follow the word size, rotations, rate and key, nonce
+# and tag lengths of the small variants of the NORX spec, with the v1
+# layout of this library around them (see Norx::_setup_small) : nonce
+# then key from word 0, the constants u = F^2 (0, ..., 15) in the words
+# left, W, R, D and the tag length in words 12 to 15. they are sequential
+# only. nothing official to check them against, the vectors are this
+# model's
+
+import sys
+import zlib
+
+ROT = {8: (1, 3, 5, 7), 16: (8, 11, 12, 15), 32: (8, 11, 16, 31), 64: (8, 19, 40, 63)}
+# rate, key and nonce words and tag bytes of the small variants
+SMALL = {8: (5, 10, 4, 10), 16: (8, 6, 2, 12)}
+U = {
+  32: [0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0x254F537A,
+       0x38531D48, 0x839C6E83, 0xF97A3AE5, 0x8C91D88C, 0x11EAFB59],
+  64: [0x243f6a8885a308d3, 0x13198a2e03707344, 0xa4093822299f31d0,
+       0x082efa98ec4e6c89, 0xAE8858DC339325A1, 0x670A134EE52D7FA6,
+       0xC4316D80CD967541, 0xD21DFBF8B630B762, 0x375A18D261E7F892,
+       0x343D1F187D92285B],
+}
+COLS = [(0, 4, 8, 12), (1, 5, 9, 13), (2, 6, 10, 14), (3, 7, 11, 15),
+        (0, 5, 10, 15), (1, 6, 11, 12), (2, 7, 8, 13), (3, 4, 9, 14)]
+
+TAG_HEADER, TAG_PAYLOAD, TAG_TRAILER, TAG_FINAL = 0x01, 0x02, 0x04, 0x08
+TAG_BRANCH, TAG_MERGE = 0x10, 0x20
+
+
+class Norx:
+  def __init__(self, w, r, d):
+    self.w, self.r, self.d = w, r, d
+    self.mask = (1 << w) - 1
+    self.wb = w // 8
+    self.rw, self.kw, self.nw, self.tag = SMALL.get(w, (10, 4, 2, w // 2))
+    self.rate = self.rw * self.wb
+
+  def ror(self, x, n):
+    return ((x >> n) | (x << (self.w - n))) & self.mask
+
+  def h(self, a, b):
+    return (a ^ b) ^ (((a & b) << 1) & self.mask)
+
+  def g(self, s, a, b, c, d):
+    r = ROT[self.w]
+    s[a] = self.h(s[a], s[b]); s[d] = self.ror(s[a] ^ s[d], r[0])
+    s[c] = self.h(s[c], s[d]); s[b] = self.ror(s[b] ^ s[c], r[1])
+    s[a] = self.h(s[a], s[b]); s[d] = self.ror(s[a] ^ s[d], r[2])
+    s[c] = self.h(s[c], s[d]); s[b] = self.ror(s[b] ^ s[c], r[3])
+
+  def f(self, s):
+    for _ in range(self.r):
+      for q in COLS:
+        self.g(s, *q)
+
+  def u(self):
+    """the constants of the small variants, F^2 of the words 0 to 15"""
+    s = list(range(16))
+    Norx(self.w, 2, 1).f(s)
+    return s
+
+  def word(self, b, i):
+    return int.from_bytes(b[i * self.wb:(i + 1) * self.wb], 'little')
+
+  def rate_bytes(self, s):
+    return b''.join(x.to_bytes(self.wb, 'little') for x in s[:self.rw])
+
+  def xor_rate(self, s, b):
+    b = b + bytes(self.rate - len(b))
+    for i in range(self.rw):
+      s[i] ^= self.word(b, i)
+
+  def pad(self, x):
+    b = bytearray(self.rate)
+    b[:len(x)] = x
+    b[len(x)] ^= 0x01
+    b[-1] ^= 0x80
+    return bytes(b)
+
+  def blocks(self, x):
+    full = len(x) - len(x) % self.rate
+    return [x[i:i + self.rate] for i in range(0, full, self.rate)] + [x[full:]]
+
+  def absorb(self, s, x, tag):
+    bl = self.blocks(x)
+    for i, b in enumerate(bl):
+      s[15] ^= tag
+      self.f(s)
+      self.xor_rate(s, self.pad(b) if i == len(bl) - 1 else b)
+
+  def encrypt_lane(self, l, b, last):
+    l[15] ^= TAG_PAYLOAD
+    self.f(l)
+    c = bytes(x ^ y for x, y in zip(self.rate_bytes(l), b))
+    if last:
+      self.xor_rate(l, self.pad(b))
+    else:
+      self.xor_rate(l, b)
+    return c
+
+  def aead(self, k, n, h, m, t):
+    """ciphertext with tag, and the state after each non empty phase"""
+    w = self.w
+    states = []
+    if w in SMALL:
+      s = [self.word(n, i) for i in range(self.nw)] + [self.word(k, i) for i in range(self.kw)]
+      s += self.u()[len(s):]
+      s[12] ^= w
+      s[13] ^= self.r
+      s[14] ^= self.d
+      s[15] ^= 8 * self.tag
+    else:
+      s = [U[w][0], self.word(n, 0), self.word(n, 1), U[w][1],
+           self.word(k, 0), self.word(k, 1), self.word(k, 2), self.word(k, 3)] + U[w][2:]
+      s[14] ^= (self.r << 26) | (self.d << 18) | (w << 10) | (4 * w)
+    self.f(s)
+    states.append(('S_Init', list(s)))
+    if h:
+      self.absorb(s, h, TAG_HEADER)
+      states.append(('S_Header', list(s)))
+    c = b''
+    if m:
+      bl = self.blocks(m)
+      if self.d == 1:
+        for i, b in enumerate(bl):
+          c += self.encrypt_lane(s, b, i == len(bl) - 1)
+      else:
+        s[15] ^= TAG_BRANCH
+        self.f(s)
+        lanes = []
+        for i in range(self.d if self.d else len(bl)):
+          l = list(s)
+          for j in range(10):
+            l[j] ^= i
+          lanes.append(l)
+        for i, b in enumerate(bl):
+          c += self.encrypt_lane(lanes[i % len(lanes)], b, i == len(bl) - 1)
+        s = [0] * 16
+        for l in lanes:
+          l[15] ^= TAG_MERGE
+          self.f(l)
+          for j in range(16):
+            s[j] ^= l[j]
+      states.append(('S_Payload', list(s)))
+    if t:
+      self.absorb(s, t, TAG_TRAILER)
+      states.append(('S_Trailer', list(s)))
+    s[15] ^= TAG_FINAL
+    self.f(s)
+    self.f(s)
+    states.append(('S_Final', list(s)))
+    return c + state_bytes(s, self.wb)[:self.tag], states
+
+
+def hexs(b):
+  return b.hex().upper()
+
+
+def state_bytes(s, wb):
+  return b''.join(x.to_bytes(wb, 'little') for x in s)
+
+
+def state_hex(s, wb):
+  return hexs(state_bytes(s, wb))
+
+
+def write(w, out):
+  out.write('# NORX v1 known answers, written by genkat.py\n')
+  out.write('# W, R and D hold until changed, CT is the ciphertext then the tag,\n')
+  out.write('# S_* the state after each non empty phase (words little endian)\n')
+  wb = w // 8
+  norx = Norx(w, 4, 1)
+  rate, kl, nl = norx.rate, norx.kw * wb, norx.nw * wb
+  count = 0
+  for r in (4, 6):
+    for d in ((1,) if w in SMALL else (1, 2, 4, 0)):
+      out.write('\nW = %d\nR = %d\nD = %d\n' % (w, r, d))
+      norx = Norx(w, r, d)
+      lens = [0, 1, rate - 1, rate, rate + 1, 2 * rate, 3 * rate + 7, 5 * rate + 3]
+      ads = [(0, 0), (3, 0), (0, 5), (rate + 2, 7)]
+      for i, ml in enumerate(lens):
+        hl, tl = ads[i % len(ads)]
+        count += 1
+        k = bytes((j * 191 + 123 + count) & 255 for j in range(kl))
+        n = bytes((j * 181 + 123 + count) & 255 for j in range(nl))
+        h = bytes((j * 193 + 123) & 255 for j in range(hl))
+        m = bytes((j * 197 + 123) & 255 for j in range(ml))
+        t = bytes((j * 199 + 123) & 255 for j in range(tl))
+        c, states = norx.aead(k, n, h, m, t)
+        out.write('\nCount = %d\n' % count)
+        out.write('Key = %s\nNonce = %s\n' % (hexs(k), hexs(n)))
+        out.write('AD = %s\nPT = %s\nTrailer = %s\n' % (hexs(h), hexs(m), hexs(t)))
+        out.write('CT = %s\n' % hexs(c))
+        # the states of the first vectors of each group only
+        if i < 4:
+          for name, s in states:
+            out.write('%s = %s\n' % (name, state_hex(s, wb)))
+
+
+def post():
+  """the digests of Norx::post : 8 chained F^4 from the words 0 to 15, and
+  a one block AEAD, key 0, 1, .., nonce 0x80, 0x81, .., payload 7 * i"""
+  for w in (8, 16, 32, 64):
+    x = Norx(w, 4, 1)
+    s = list(range(16))
+    for _ in range(8):
+      x.f(s)
+    k = bytes(range(x.kw * x.wb))
+    n = bytes(0x80 + i for i in range(x.nw * x.wb))
+    m = bytes((7 * i) & 255 for i in range(x.rate))
+    c, _ = x.aead(k, n, b'', m, b'')
+    print('  { %2d, 0x%08xUL, 0x%08xUL },' % (w, zlib.crc32(state_bytes(s, x.wb)), zlib.crc32(c)))
+
+
+def drbg(w, r, e, pers, n):
+  """n bytes of NorxDrbg seeded with e and pers (norx_drbg.h)"""
+  x = Norx(w, r, 1)
+  s = [0] * 16
+
+  def absorb(data, tag):
+    i = 0
+    while True:
+      b = data[i:i + x.rate]
+      i += len(b)
+      s[15] ^= tag
+      x.f(s)
+      if len(b) < x.rate:
+        x.xor_rate(s, x.pad(b))
+        return
+      x.xor_rate(s, b)
+
+  absorb(e, 0x40)
+  if pers:
+    absorb(pers, 0x41)
+  out = b''
+  while len(out) < n:
+    s[15] ^= 0x42
+    x.f(s)
+    out += x.rate_bytes(s)
+    s[:x.rw] = [0] * x.rw
+  return out[:n]
+
+
+if __name__ == '__main__':
+  if sys.argv[1:] == ['--post']:
+    post()
+    sys.exit(0)
+  if sys.argv[1:] == ['--drbg']:
+    # the known answers of NorxDrbg::test, entropy 0 to 47, pers "drbg"
+    for w in (32, 64):
+      out = drbg(w, 4, bytes(range(48)), b'drbg', 100)
+      print('%d 0x%08x %s' % (w, zlib.crc32(out), hexs(out)))
+    sys.exit(0)
+  for w in (8, 16, 32, 64):
+    with open('norx%d.txt' % w, 'w') as f:
+      write(w, f)
@@ -0,0 +1,68 @@
+#include "Arduino.h"
+#include "norx.h"
+#include "norx_batch.h"
+#include "norx_stack.h"
+#include "norx_step.h"
+#include "norx_drbg.h"
+
+/***************************************************************************
+ * host equivalent of norxtest.ino's setup (), the stack peaks are those of
+ * the host build
+ */
+
+Norx norx;
+NorxStep step (&norx);
+NorxDrbg drbg (&norx);
+#if NORX_BATCH
+NorxBatch batch (&norx);
+#endif
+bool ok;
+uint8_t buf[64 + NORX_MAX_TAG_SIZE];
+unsigned long post_us;
+
+// the quiet power-on self test, timed
+void power_on (void* arg) {
+  post_us = micros ();
+  ok = norx.post ();
+  post_us = micros () - post_us;
+}
+
+#if NORX_DIAG
+// every test vector, printed
+void self_test (void* arg) {
+  ok &= norx.test ();
+}
+#endif
+
+// one shot NORX64 (NORX32 with NORX_64=0) over 64 bytes, there and back
+void one_shot (void* arg) {
+  uint8_t key[32] = { 0 };
+  uint8_t nonce[16] = { 0 };
+  norx.encrypt (NORX_MAX_BITS, key, nonce, NULL, 0, buf, 64, NULL, 0, buf);
+  ok &= norx.decrypt (NORX_MAX_BITS, key, nonce, NULL, 0, buf, 64 + (NORX_MAX_BITS>>1), NULL, 0, buf);
+}
+
+void report (const __FlashStringHelper* what, size_t n) {
+  Serial.print (what);
+  Serial.print ((unsigned long)n);
+  Serial.println (F(" bytes"));
+}
+
+int main (int argc, char** argv) {
+  Serial.begin (9600);
+  Serial.println (F("Norx testbed"));
+  report (F("stack peak, power-on self test : "), norx_stack_measure (power_on, NULL));
+  Serial.print (ok ? F("power-on self test PASS, ") : F("power-on self test FAIL, "));
+  Serial.print (post_us);
+  Serial.println (F(" us"));
+#if NORX_DIAG
+  report (F("stack peak, self test : "), norx_stack_measure (self_test, NULL));
+#endif
+  report (F("stack peak, one shot AEAD : "), norx_stack_measure (one_shot, NULL));
+  ok &= step.test ();
+  ok &= drbg.test ();
+#if NORX_BATCH
+  ok &= batch.test ();
+#endif
+  return ok ? 0 : 1;
+}
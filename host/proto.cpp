@@ -0,0 +1,187 @@
+#include <signal.h>
+#include <sys/wait.h>
+#include "client.h"
+
+/***************************************************************************
+ * pty loopback test of the framed serial protocol (norx_proto.h)
+ *
+ *   norxproto
+ *
+ * a child process plays the board : the sketch's banner, then NorxProto
+ * polled on the slave side of a pty, as loop () does. the parent talks to
+ * it through the master side with NorxClient, and checks every reply
+ * against the one shot API of a local Norx : messages of many sizes in
+ * chunks of every size, both widths, D 1 and 2, a forged tag, commands out
+ * of order, a damaged and an oversized frame
+ */
+
+static unsigned long checks, failed;
+
+static void check (bool c, const char* what, int st) {
+  checks++;
+  if (c) return;
+  failed++;
+  printf ("FAIL %s, status %d\n", what, st);
+}
+
+/* the board, until the pty is closed */
+static void board (int fd) {
+  Norx norx;
+  NorxProto proto (&norx);
+  struct pollfd p;
+
+  Serial.attach (fd);
+  Serial.println (F("Norx testbed"));
+  for (;;) {
+    if (proto.poll ()) continue;
+    p.fd = fd;
+    p.events = POLLIN;
+    if ((::poll (&p, 1, 100)>0)&&(p.revents & (POLLHUP | POLLERR))&&(Serial.available ()<=0)) break;
+  }
+  exit (0);
+}
+
+/* one message through the board, against the local one shot */
+static void message (NorxClient* c, Norx* x, uint8_t bits, uint8_t d, size_t hlen, size_t mlen, size_t tlen) {
+  static uint8_t key[32], nonce[16], h[300], m[3000], t[300];
+  static uint8_t ref[3000 + 32], out[3000 + 32], back[3000];
+  uint8_t tl = bits >> 1;
+  size_t i;
+  int st;
+
+  for (i=0;i<sizeof(key);i++) key[i] = i * 3 + bits + d;
+  for (i=0;i<sizeof(nonce);i++) nonce[i] = mlen + i;
+  for (i=0;i<hlen;i++) h[i] = i ^ 0x11;
+  for (i=0;i<mlen;i++) m[i] = i * 7;
+  for (i=0;i<tlen;i++) t[i] = i ^ 0x22;
+  x->begin (4, d);
+  x->encrypt (bits, key, nonce, h, hlen, m, mlen, t, tlen, ref);
+
+  st = c->key (bits, 4, d, key);
+  check (st==NORX_PROTO_OK, "KEY", st);
+  st = c->call (NORX_CMD_NONCE, nonce, bits >> 2);
+  st |= c->stream (NORX_CMD_HEADER, h, hlen, NULL);
+  st |= c->stream (NORX_CMD_ENCRYPT, m, mlen, out);
+  st |= c->stream (NORX_CMD_TRAILER, t, tlen, NULL);
+  st |= c->call (NORX_CMD_TAG, NULL, 0, out + mlen);
+  check ((st==NORX_PROTO_OK)&&!memcmp (out, ref, mlen + tl), "encrypt", st);
+
+  st = c->call (NORX_CMD_NONCE, nonce, bits >> 2);
+  st |= c->stream (NORX_CMD_HEADER, h, hlen, NULL);
+  st |= c->stream (NORX_CMD_DECRYPT, ref, mlen, back);
+  st |= c->stream (NORX_CMD_TRAILER, t, tlen, NULL);
+  st |= c->call (NORX_CMD_VERIFY, ref + mlen, tl);
+  check ((st==NORX_PROTO_OK)&&!memcmp (back, m, mlen), "decrypt", st);
+
+  ref[mlen] ^= 1;
+  st = c->call (NORX_CMD_NONCE, nonce, bits >> 2);
+  st |= c->stream (NORX_CMD_HEADER, h, hlen, NULL);
+  st |= c->stream (NORX_CMD_DECRYPT, ref, mlen, back);
+  st |= c->stream (NORX_CMD_TRAILER, t, tlen, NULL);
+  check (st==NORX_PROTO_OK, "decrypt, forged", st);
+  st = c->call (NORX_CMD_VERIFY, ref + mlen, tl);
+  check (st==NORX_PROTO_TAG, "forged tag", st);
+}
+
+/* what the board must refuse, and that it carries on afterwards */
+static void errors (NorxClient* c, int fd) {
+  uint8_t key[16], nonce[8], b[4];
+  uint8_t bad[] = { NORX_PROTO_SOF, NORX_CMD_INFO, 0, 0, 0, 0, 0, 0 };
+  uint8_t big[] = { NORX_PROTO_SOF, NORX_CMD_HEADER, 0xff, 0xff };
+  uint8_t r;
+  uint16_t n;
+  int st;
+
+  memset (key, 1, sizeof(key));
+  memset (nonce, 2, sizeof(nonce));
+  st = c->call (NORX_CMD_WIPE, NULL, 0);
+  check (st==NORX_PROTO_OK, "WIPE", st);
+  st = c->call (NORX_CMD_NONCE, nonce, 8);
+  check (st==NORX_PROTO_ORDER, "NONCE without a key", st);
+  st = c->call (NORX_CMD_HEADER, nonce, 8);
+  check (st==NORX_PROTO_ORDER, "HEADER without a key", st);
+  st = c->call (0x42, NULL, 0);
+  check (st==NORX_PROTO_CMD, "unknown command", st);
+  b[0] = 48;
+  b[1] = 4;
+  b[2] = 1;
+  st = c->call (NORX_CMD_KEY, b, 3);
+  check (st==NORX_PROTO_PARAM, "KEY, 48 bits", st);
+  st = c->key (32, 4, 1, key);
+  check (st==NORX_PROTO_OK, "KEY", st);
+  st = c->call (NORX_CMD_HEADER, nonce, 8);
+  check (st==NORX_PROTO_ORDER, "HEADER before NONCE", st);
+  st = c->call (NORX_CMD_NONCE, nonce, 7);
+  check (st==NORX_PROTO_LENGTH, "NONCE, 7 bytes", st);
+  st = c->call (NORX_CMD_NONCE, nonce, 8);
+  check (st==NORX_PROTO_OK, "NONCE", st);
+  st = c->call (NORX_CMD_ENCRYPT, key, 16, key);
+  check (st==NORX_PROTO_OK, "ENCRYPT", st);
+  st = c->call (NORX_CMD_HEADER, nonce, 8);
+  check (st==NORX_PROTO_ORDER, "HEADER after ENCRYPT", st);
+  st = c->call (NORX_CMD_VERIFY, key, 3);
+  check (st==NORX_PROTO_LENGTH, "VERIFY, 3 bytes", st);
+
+  // a damaged frame, then one too long for the board
+  check (write (fd, bad, sizeof(bad))==sizeof(bad), "write", 0);
+  st = c->receive (&r, NULL, &n);
+  check ((st==NORX_PROTO_CRC)&&(r==NORX_CMD_ERROR), "bad CRC", st);
+  check (write (fd, big, sizeof(big))==sizeof(big), "write", 0);
+  st = c->receive (&r, NULL, &n);
+  check ((st==NORX_PROTO_LENGTH)&&(r==NORX_CMD_ERROR), "oversized frame", st);
+  st = c->call (NORX_CMD_TAG, NULL, 0, key);
+  check (st==NORX_PROTO_OK, "TAG after the errors", st);
+  st = c->call (NORX_CMD_TAG, NULL, 0, key);
+  check (st==NORX_PROTO_ORDER, "second TAG", st);
+}
+
+int main (int argc, char** argv) {
+  const size_t sizes[] = { 0, 1, 39, 40, 41, 80, 200, 1023, 1024, 1025, 2999 };
+  struct termios tio;
+  uint8_t version, max_bits, bits, d;
+  int master, slave, st;
+  pid_t pid;
+  size_t i;
+  Norx x;
+
+  master = posix_openpt (O_RDWR | O_NOCTTY);
+  if ((master<0)||grantpt (master)||unlockpt (master)) {
+    perror ("posix_openpt");
+    return 2;
+  }
+  slave = open (ptsname (master), O_RDWR | O_NOCTTY);
+  if (slave<0) {
+    perror ("pty");
+    return 2;
+  }
+  tcgetattr (slave, &tio);
+  cfmakeraw (&tio);
+  tcsetattr (slave, TCSANOW, &tio);
+
+  fflush (stdout);
+  pid = fork ();
+  if (pid==0) {
+    close (master);
+    board (slave);
+  }
+  close (slave);
+
+  // Norx::begin's banner
+  Serial.out = NULL;
+  NorxClient c (master);
+  st = c.info (&version, &max_bits);
+  check ((st==NORX_PROTO_OK)&&(version==NORX_PROTO_VERSION)&&(max_bits==NORX_MAX_BITS), "INFO", st);
+  errors (&c, master);
+  for (bits=32;bits<=NORX_MAX_BITS;bits+=32)
+    for (d=1;d<=2;d++)
+      for (i=0;i<sizeof(sizes)/sizeof(sizes[0]);i++)
+        message (&c, &x, bits, d, sizes[i] % 300, sizes[i], sizes[(i + 3) % 11] % 300);
+  // smaller frames, more of them in flight
+  c.max = 7;
+  message (&c, &x, 32, 1, 20, 100, 9);
+
+  close (master);
+  waitpid (pid, NULL, 0);
+  printf ("pty loopback : %lu checks, %lu failed\n", checks, failed);
+  return failed ? 1 : 0;
+}
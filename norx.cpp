@@ -1,14 +1,31 @@
 #include <string.h>
 #include <avr/pgmspace.h>
 #include "norx.h"
+#include "norx_core.h"
+#include "norx_bi64.h"
+#include "norx_simd.h"
+#include "norx_pool.h"
+#include "norx_ct.h"
 #include "cryptoutils.h"
 
 Norx::Norx (void) {
+  this->rounds = 4;
+  this->d = 1;
+  this->cur = &(this->state);
+  this->sink = NULL;
+#if NORX_STATS
+  this->stats_reset ();
+#endif
 }
 
-void Norx::begin (uint8_t rounds) {
-  Serial.println ("initializing Norx instance");
+bool Norx::begin (uint8_t rounds, uint8_t d) {
+  Serial.println (F("initializing Norx instance"));
+  // R goes in 6 bits of the parameter word
+  if ((rounds<1)||(rounds>63)) return 0;
+  if ((d>NORX_MAX_LANES)||((d==0)&&(NORX_MAX_LANES<2))) return 0;
   this->rounds = rounds;
+  this->d = d;
+  return 1;
 }
 
 /***************************************************************************
@@ -101,22 +118,91 @@ void Norx::__G_64 (stw* wa, stw* wb, stw* wc, stw* wd) {
   this->_XRL_64(wb, wb, wc, r[3]);
 }
 
-void Norx::_G (state_t* s, uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
-  if (s->bits==32) this->__G_32 (&(s->state[a]), &(s->state[b]), &(s->state[c]), &(s->state[d]));
-  if (s->bits==64) this->__G_64 (&(s->state[a]), &(s->state[b]), &(s->state[c]), &(s->state[d]));
+void Norx::_G_ref (state_t* s, uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+  uint8_t x[4] = { a, b, c, d };
+  uint8_t i;
+  stw w[4];
+  for (i=0;i<4;i++) w[i].b64 = this->_word (s, x[i]);
+  if (s->bits==32) this->__G_32 (&(w[0]), &(w[1]), &(w[2]), &(w[3]));
+  if (s->bits==64) this->__G_64 (&(w[0]), &(w[1]), &(w[2]), &(w[3]));
+  for (i=0;i<4;i++) this->_set_word (s, x[i], (s->bits==32) ? w[i].b32 : w[i].b64);
 }
-  
-void Norx::_F (state_t* s) {
+
+/* reference F, built on __G_32 / __G_64 */
+void Norx::_F_ref (state_t* s) {
   // columns
-  this->_G (s, 0, 4, 8, 12);
-  this->_G (s, 1, 5, 9, 13);
-  this->_G (s, 2, 6, 10, 14);
-  this->_G (s, 3, 7, 11, 15);
+  this->_G_ref (s, 0, 4, 8, 12);
+  this->_G_ref (s, 1, 5, 9, 13);
+  this->_G_ref (s, 2, 6, 10, 14);
+  this->_G_ref (s, 3, 7, 11, 15);
   // diagonals
-  this->_G (s, 0, 5, 10, 15);
-  this->_G (s, 1, 6, 11, 12);
-  this->_G (s, 2, 7, 8, 13);
-  this->_G (s, 3, 4, 9, 14);
+  this->_G_ref (s, 0, 5, 10, 15);
+  this->_G_ref (s, 1, 6, 11, 12);
+  this->_G_ref (s, 2, 7, 8, 13);
+  this->_G_ref (s, 3, 4, 9, 14);
+}
+
+/***************************************************************************
+ * dispatch to the compile-time specialized core (norx_core.h), which works
+ * on the words of s32 / s64 directly
+ */
+
+void Norx::_G (state_t* s, uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+#if NORX_SMALL
+  if (s->bits==8) Norx8F::G (s->s8.w[a], s->s8.w[b], s->s8.w[c], s->s8.w[d]);
+  if (s->bits==16) Norx16F::G (s->s16.w[a], s->s16.w[b], s->s16.w[c], s->s16.w[d]);
+#endif
+  if (s->bits==32) Norx32F::G (s->s32.w[a], s->s32.w[b], s->s32.w[c], s->s32.w[d]);
+#if NORX_64
+  if (s->bits==64) Norx64F::G (s->s64.w[a], s->s64.w[b], s->s64.w[c], s->s64.w[d]);
+#endif
+}
+
+void Norx::_F (state_t* s) {
+  this->_permute (s, 1);
+}
+
+/* F^r, fully unrolled for the usual round counts */
+static void _permute_c (state_t* s, uint8_t r) {
+#if NORX_SMALL
+  if (s->bits==8) {
+    if (r==4) NorxCore<uint8_t, 4>::permute (s->s8.w);
+    else while (r--) Norx8F::permute (s->s8.w);
+  }
+  if (s->bits==16) {
+    if (r==4) NorxCore<uint16_t, 4>::permute (s->s16.w);
+    else while (r--) Norx16F::permute (s->s16.w);
+  }
+#endif
+  if (s->bits==32) {
+    if (r==4) NorxCore<uint32_t, 4>::permute (s->s32.w);
+    else if (r==6) NorxCore<uint32_t, 6>::permute (s->s32.w);
+    else while (r--) Norx32F::permute (s->s32.w);
+  }
+#if NORX_64
+  if (s->bits==64) {
+#if NORX_BI64
+    if (r==4) NorxBi64<4>::permute (s->s64.w);
+    else if (r==6) NorxBi64<6>::permute (s->s64.w);
+    else NorxBi64F::permute (s->s64.w, r);
+#else
+    if (r==4) NorxCore<uint64_t, 4>::permute (s->s64.w);
+    else if (r==6) NorxCore<uint64_t, 6>::permute (s->s64.w);
+    else while (r--) Norx64F::permute (s->s64.w);
+#endif
+  }
+#endif
+}
+
+/* F^r, vectorized when the host allows */
+void Norx::_permute (state_t* s, uint8_t r) {
+  NORX_PROBE_BEGIN (p);
+  NORX_STAT_ROUNDS (r);
+#if NORX_SIMD
+  if (!norx_simd_permute (s, r))
+#endif
+    _permute_c (s, r);
+  NORX_PROBE_END (p, NORX_STAT_F);
 }
  
 
@@ -129,55 +215,63 @@ void Norx::_F (state_t* s) {
  * a => tag size
  * k => key (4 words)
  * n => nonce (2 words)
+ *
+ * _setup loads the state up to the parameter word, _init also runs F^R
+ *
+ * NORX8 and NORX16 take the word size, rotations, rate and key, nonce and
+ * tag lengths of the small variants of the NORX spec, with the v1 layout
+ * of this file around them : _setup_small puts the nonce then the key from
+ * word 0, the constants u = F^2 (0, ..., 15) in the words left, and XORs W,
+ * R, D and the tag bits into words 12 to 15. they are sequential, D is 1.
+ * the known answers (host/kat) come from genkat.py, there is nothing
+ * official to check them against
+ *
+ *            key       nonce     tag       rate
+ *   NORX8    10 bytes  4 bytes   10 bytes  5 bytes
+ *   NORX16   12 bytes  4 bytes   12 bytes  16 bytes
  */
-void Norx::_init (state_t* s, uint8_t w, uint8_t r, uint8_t d, uint8_t a, stw k[4], stw n[2], uint16_t hlen) {
+
+// the constants u0 to u9, for words 0, 3 and 8 to 15
+const uint32_t NORX_INIT_32[10] PROGMEM = {
+  0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0x254F537A,
+  0x38531D48, 0x839C6E83, 0xF97A3AE5, 0x8C91D88C, 0x11EAFB59
+};
+
+#if NORX_64
+const uint64_t NORX_INIT_64[10] PROGMEM = {
+  0x243f6a8885a308d3, 0x13198a2e03707344, 0xa4093822299f31d0, 0x082efa98ec4e6c89,
+  0xAE8858DC339325A1, 0x670A134EE52D7FA6, 0xC4316D80CD967541, 0xD21DFBF8B630B762,
+  0x375A18D261E7F892, 0x343D1F187D92285B
+};
+#endif
+
+void Norx::_setup (state_t* s, uint8_t w, uint8_t r, uint8_t d, uint16_t a, stw k[4], stw n[2]) {
+  stw c;
   uint64_t v;
-  uint8_t i;
   uint32_t r64;
   uint32_t w64;
   uint32_t d64;
   uint32_t a64;
+  uint8_t i;
   
   s->bits = w;
   s->rounds = r;
   
   // set up nonce and key
   
-  this->copy_state_word(w, &(n[0]), &(s->state[1]));
-  this->copy_state_word(w, &(n[1]), &(s->state[2]));
-  
-  this->copy_state_word(w, &(k[0]), &(s->state[4]));
-  this->copy_state_word(w, &(k[1]), &(s->state[5]));
-  this->copy_state_word(w, &(k[2]), &(s->state[6]));
-  this->copy_state_word(w, &(k[3]), &(s->state[7]));
+  for (i=0;i<2;i++) this->_set_word (s, 1+i, (w==32) ? n[i].b32 : n[i].b64);
+  for (i=0;i<4;i++) this->_set_word (s, 4+i, (w==32) ? k[i].b32 : k[i].b64);
   
-  // inject constants
+  // inject constants, streamed from flash a word at a time
   
-  if (w==32) {
-    s->state[ 0].b32 = 0x243f6a88;
-    s->state[ 3].b32 = 0x85a308d3;
-    s->state[ 8].b32 = 0x13198a2e;
-    s->state[ 9].b32 = 0x03707344;
-    s->state[10].b32 = 0x254F537A;
-    s->state[11].b32 = 0x38531D48;
-    s->state[12].b32 = 0x839C6E83;
-    s->state[13].b32 = 0xF97A3AE5;
-    s->state[14].b32 = 0x8C91D88C;
-    s->state[15].b32 = 0x11EAFB59;
-  }
-  if (w==64) {
-    s->state[ 0].b64 = 0x243f6a8885a308d3;
-    s->state[ 3].b64 = 0x13198a2e03707344;
-    s->state[ 8].b64 = 0xa4093822299f31d0;
-    s->state[ 9].b64 = 0x082efa98ec4e6c89;
-    s->state[10].b64 = 0xAE8858DC339325A1;
-    s->state[11].b64 = 0x670A134EE52D7FA6;
-    s->state[12].b64 = 0xC4316D80CD967541;
-    s->state[13].b64 = 0xD21DFBF8B630B762;
-    s->state[14].b64 = 0x375A18D261E7F892;
-    s->state[15].b64 = 0x343D1F187D92285B;
-  }
-  this->dump_state(s, "const ");
+  for (i=0;i<10;i++) {
+    if (w==32) this->prgm_copy_state_word (w, (void*)&(NORX_INIT_32[i]), &c);
+#if NORX_64
+    if (w==64) this->prgm_copy_state_word (w, (void*)&(NORX_INIT_64[i]), &c);
+#endif
+    this->_set_word (s, (i<2) ? 3*i : i+6, (w==32) ? c.b32 : c.b64);
+  }
+  NORX_TRACE (s, "const ");
   
   // integrate parameters
 
@@ -187,26 +281,754 @@ void Norx::_init (state_t* s, uint8_t w, uint8_t r, uint8_t d, uint8_t a, stw k[
   a64 = a;
  
   v = (r64<<26) | (d64<<18) | (w64<<10) | a64;
-  if (w==32) {
-    Serial.println("32 bits");
-    s->state[14].b32 ^= (uint32_t)v;
-    print_32_bits (v);
-    Serial.println();
-  }
-  if (w==64) {
-    Serial.println("64 bits");
-    s->state[14].b64 ^= v;
-    print_64_bits (v);
-    Serial.println();
-  }
-  this->dump_state(s,"parmF ");
-  for (i=0;i<r;++i) {
-    Serial.println(i);  
+  this->_xor_word (s, 14, v);
+  NORX_TRACE (s, "parmF ");
+}
+
+// tag bytes at width bits
+static uint8_t _tag_of (uint8_t bits) {
+#if NORX_SMALL
+  if (bits==8) return 10;
+  if (bits==16) return 12;
+#endif
+  return bits >> 1;
+}
+
+// 32, NORX_MAX_BITS, and 8 and 16 with NORX_SMALL
+static bool _built_in (uint8_t bits) {
+  if ((bits==32)||(bits==NORX_MAX_BITS)) return 1;
+  return NORX_SMALL && ((bits==8)||(bits==16));
+}
+
+#if NORX_SMALL
+// u0 to u15 of NORX8 and NORX16, F^2 of the words 0 to 15 (_test_small)
+const uint8_t NORX_INIT_8[16] PROGMEM = {
+  0x88, 0x97, 0x7f, 0x55, 0x68, 0x7b, 0xb4, 0x6f,
+  0x48, 0x60, 0x17, 0xf7, 0x14, 0x80, 0x3f, 0x55
+};
+
+const uint16_t NORX_INIT_16[16] PROGMEM = {
+  0x62c0, 0xb797, 0x369a, 0xb231, 0xd42c, 0x28fc, 0x2a74, 0x566f,
+  0x2d5a, 0x6714, 0xb2ed, 0xe036, 0x181d, 0x200e, 0x92cd, 0xedc8
+};
+
+void Norx::_setup_small (state_t* s, uint8_t w, uint8_t r, const uint8_t* key, const uint8_t* nonce) {
+  uint8_t i, wb = w >> 3;
+  uint8_t nw = (w==8) ? 4 : 2;
+  uint8_t kw = (w==8) ? 10 : 6;
+  stw c;
+
+  s->bits = w;
+  s->rounds = r;
+  for (i=0;i<16;i++) {
+    if (i<nw) {
+      c.b64 = 0;
+      if (nonce) this->_load_word (w, &c, nonce + i*wb);
+    } else if (i<nw+kw) {
+      this->_load_word (w, &c, key + (i-nw)*wb);
+    } else {
+      c.b64 = (w==8) ? pgm_read_byte (&(NORX_INIT_8[i])) : pgm_read_word (&(NORX_INIT_16[i]));
+    }
+    this->_set_word (s, i, c.b64);
+  }
+  c.b64 = 0;
+  NORX_TRACE (s, "const ");
+
+  this->_xor_word (s, 12, w);
+  this->_xor_word (s, 13, r);
+  this->_xor_word (s, 14, 1);
+  this->_xor_word (s, 15, 8 * _tag_of (w));
+  NORX_TRACE (s, "parmF ");
+}
+#endif
+
+/* _setup from key and nonce bytes, a NULL nonce is all zero. returns 0
+   and leaves s alone if bits is not built in */
+bool Norx::_load (state_t* s, uint8_t bits, const uint8_t* key, const uint8_t* nonce) {
+  stw k[4];
+  stw n[2];
+  uint8_t i, wb = bits >> 3;
+
+  if (!_built_in (bits)) return 0;
+#if NORX_SMALL
+  if (bits<32) {
+    this->_setup_small (s, bits, this->rounds, key, nonce);
+    return 1;
+  }
+#endif
+  for (i=0;i<4;i++) this->_load_word (bits, &(k[i]), key + i*wb);
+  memset (n, 0, sizeof(n));
+  if (nonce)
+    for (i=0;i<2;i++) this->_load_word (bits, &(n[i]), nonce + i*wb);
+  this->_setup (s, bits, this->rounds, this->d, bits*4, k, n);
+  memset (k, 0, sizeof(k));
+  return 1;
+}
+
+/* the nonce words of a set up state, 1 and 2, or from 0 on NORX8/16 */
+void Norx::_nonce (state_t* s, const uint8_t* nonce) {
+  uint8_t i, bits = s->bits, wb = bits >> 3;
+  uint8_t nw = 2, at = 1;
+  stw n;
+#if NORX_SMALL
+  if (bits==8) nw = 4;
+  if (bits<32) at = 0;
+#endif
+  for (i=0;i<nw;i++) {
+    this->_load_word (bits, &n, nonce + i*wb);
+    this->_set_word (s, at+i, n.b64);
+  }
+}
+
+void Norx::_init (state_t* s, uint8_t w, uint8_t r, uint8_t d, uint16_t a, stw k[4], stw n[2], uint16_t hlen) {
+  this->_setup (s, w, r, d, a, k, n);
+  this->_init_F (s, r);
+}
+
+/* the F^R closing the initialization */
+void Norx::_init_F (state_t* s, uint8_t r) {
+#if NORX_TRACE_LEVEL >= NORX_TRACE_ROUND
+  for (uint8_t i=0;i<r;++i) {
     this->_F (s);
-    this->dump_state(s, "      ");
+    NORX_TRACE_ROUND_STATE (s, "      ");
   }
+#else
+  this->_permute (s, r);
+#endif
   
-  this->dump_state(s, "init  ");
+  NORX_TRACE (s, "init  ");
+}
+
+/***************************************************************************
+ * AEAD functions
+ *
+ * the rate (words 0 to 9) is used directly as the block buffer: a block is
+ * opened (domain tag injected, F^R applied) when its first byte arrives,
+ * and each byte is then XORed in place, so update calls can have any size.
+ * pos is the number of rate bytes used in the current block, pos==rate
+ * meaning no block is open. the padding is applied when the phase is
+ * closed, which is when the next phase starts.
+ *
+ * the rate bytes go to cur, which is the state itself except in the
+ * payload phase of the parallel modes, see below.
+ *
+ * note : streaming decrypt hands out plaintext before the tag is checked,
+ * it must not be used before verify has returned true
+ */
+
+static uint8_t _rate_of (uint8_t bits) {
+#if NORX_SMALL
+  if (bits==8) return 5;
+  if (bits==16) return 16;
+#endif
+  return 10 * (bits >> 3);
+}
+
+uint8_t Norx::_rate (state_t* s) {
+  return _rate_of (s->bits);
+}
+
+/* rate byte i of the state, words are little endian. the members of the
+   union all start at the same address */
+uint8_t* Norx::_rate_byte (state_t* s, uint8_t i) {
+#if NORX_64
+  if (s->bits==64) return ((uint8_t*)s->s64.w) + i;
+#endif
+  return ((uint8_t*)s->s32.w) + i;
+}
+
+void Norx::_load_word (uint8_t bits, stw* w, const uint8_t* p) {
+  uint8_t i;
+  w->b64 = 0;
+  for (i=bits>>3;i>0;i--) {
+    w->b64 <<= 8;
+    w->b64 |= p[i-1];
+  }
+}
+
+void Norx::_inject (state_t* s, uint8_t v) {
+  this->_xor_word (s, 15, v);
+}
+
+/* lanes for the payload, NORX8 and NORX16 have none */
+bool Norx::_parallel (void) {
+  return (this->d!=1)&&(this->state.bits>=32);
+}
+
+void Norx::_next_block (void) {
+  if ((this->phase==NORX_TAG_PAYLOAD)&&this->_parallel ()) this->_next_lane ();
+  this->_inject (this->cur, this->phase);
+  this->_permute (this->cur, this->rounds);
+  this->pos = 0;
+}
+
+/* runs len bytes of the current phase through the rate */
+void Norx::_duplex (uint8_t* out, const uint8_t* in, size_t len, uint8_t mode) {
+  uint8_t rate = this->_rate (&(this->state));
+  uint8_t* b;
+  uint8_t c;
+  NORX_PROBE_BEGIN (p);
+
+  if (len) this->used = 1;
+  // an instrumented build keeps every F^R on this thread
+#if NORX_THREADS && !NORX_STATS
+  if ((mode!=NORX_MODE_ABSORB)&&this->_parallel ()&&(this->pos==rate)&&(len>=NORX_THREADS_MIN)) {
+    size_t n = len / rate;
+    this->_bulk (out, in, n, mode);
+    in += n * rate;
+    out += n * rate;
+    len -= n * rate;
+  }
+#endif
+  while (len) {
+    if (this->pos==rate) {
+      this->_next_block ();
+      // whole blocks go word by word
+      if (len>=rate) {
+        this->_rate_block (this->cur, out, in, mode);
+        this->pos = rate;
+        in += rate;
+        if (mode!=NORX_MODE_ABSORB) out += rate;
+        len -= rate;
+        continue;
+      }
+    }
+    len--;
+    b = this->_rate_byte (this->cur, this->pos++);
+    c = *in++;
+    if (mode==NORX_MODE_DECRYPT) {
+      *out++ = *b ^ c;
+      *b = c;
+    } else {
+      *b ^= c;
+      if (mode==NORX_MODE_ENCRYPT) *out++ = *b;
+    }
+  }
+  NORX_PROBE_END (p, NORX_STAT_PHASE (this->phase));
+}
+
+/* XORs a whole block between in, out and the rate words, like _duplex
+   does byte by byte. memcpy lets in and out be unaligned and the same
+   buffer, and the rate words are little endian, as in _rate_byte */
+template <typename W>
+static void _rate_xor (W* s, uint8_t* out, const uint8_t* in, uint8_t mode, uint8_t n) {
+  uint8_t i;
+  W c, p;
+  for (i=0;i<n;i++,in+=sizeof(W)) {
+    memcpy (&c, in, sizeof(W));
+    if (mode==NORX_MODE_DECRYPT) {
+      p = s[i] ^ c;
+      s[i] = c;
+      memcpy (out, &p, sizeof(W));
+    } else {
+      s[i] ^= c;
+      if (mode==NORX_MODE_ENCRYPT) memcpy (out, &(s[i]), sizeof(W));
+    }
+    if (mode!=NORX_MODE_ABSORB) out += sizeof(W);
+  }
+}
+
+void Norx::_rate_block (state_t* s, uint8_t* out, const uint8_t* in, uint8_t mode) {
+#if NORX_SMALL
+  if (s->bits==8) _rate_xor<uint8_t> (s->s8.w, out, in, mode, 5);
+  if (s->bits==16) _rate_xor<uint16_t> (s->s16.w, out, in, mode, 8);
+#endif
+  if (s->bits==32) _rate_xor<uint32_t> (s->s32.w, out, in, mode, 10);
+#if NORX_64
+  if (s->bits==64) _rate_xor<uint64_t> (s->s64.w, out, in, mode, 10);
+#endif
+}
+
+/* closes the current phase, padding its last block */
+void Norx::_end_phase (void) {
+  if (!this->used) return;
+  if (this->pos==this->_rate (&(this->state))) this->_next_block ();
+  this->_pad ();
+}
+
+void Norx::_pad (void) {
+  *(this->_rate_byte (this->cur, this->pos)) ^= 0x01;
+  *(this->_rate_byte (this->cur, this->_rate (this->cur) - 1)) ^= 0x80;
+}
+
+/* moves to phase p, phases can be skipped but not revisited */
+bool Norx::_phase (uint8_t p) {
+  if (this->phase==p) return 1;
+  if (this->phase>p) return 0;
+  // closed, merged for the parallel payload, then traced
+  if (this->used) {
+    NORX_PROBE_BEGIN (q);
+    this->_end_phase ();
+    if ((this->phase==NORX_TAG_PAYLOAD)&&(this->blk)) this->_merge_lanes ();
+    NORX_PROBE_END (q, NORX_STAT_PHASE (this->phase));
+    if (this->phase==NORX_TAG_HEADER) NORX_TRACE (&(this->state), "header");
+    if (this->phase==NORX_TAG_PAYLOAD) NORX_TRACE (&(this->state), "payld ");
+    if (this->phase==NORX_TAG_TRAILER) NORX_TRACE (&(this->state), "trail ");
+  }
+  this->phase = p;
+  this->pos = this->_rate (&(this->state));
+  this->used = 0;
+  return 1;
+}
+
+/***************************************************************************
+ * parallel payload, D>1 or D=0
+ *
+ * on the first payload block the state branches: the tag 0x10 is injected,
+ * F^R applied, and lane i is a copy with i XORed into each rate word.
+ * payload block j goes to lane j%D, or with D=0 to a lane of its own, id j.
+ * once the payload is over each lane gets the tag 0x20 and F^R, and the
+ * state is the XOR of all of them. D=0 keeps the branched state in state,
+ * the lane of the current block in lane[0] and the running merge in
+ * lane[1]. an empty payload does not branch at all, like with D=1 the
+ * phase is skipped
+ */
+
+void Norx::_lane_id (state_t* s, size_t id) {
+  uint8_t i;
+  for (i=0;i<10;i++) this->_xor_word (s, i, id);
+}
+
+void Norx::_branch (void) {
+  this->_inject (&(this->state), NORX_TAG_BRANCH);
+  this->_permute (&(this->state), this->rounds);
+  this->_fork ();
+}
+
+/* the lanes, from the branched state */
+void Norx::_fork (void) {
+  uint8_t i;
+  for (i=0;i<this->d;i++) {
+    this->copy_state (&(this->state), &(this->lane[i]));
+    this->_lane_id (&(this->lane[i]), i);
+  }
+  if (!this->d) this->empty_state (this->state.bits, &(this->lane[1]));
+}
+
+/* picks the lane of the block about to be opened */
+void Norx::_next_lane (void) {
+  if (!this->blk) this->_branch ();
+  if (this->d) {
+    this->cur = &(this->lane[this->blk % this->d]);
+  } else {
+    if (this->open) this->_merge (&(this->lane[0]), &(this->lane[1]));
+    this->copy_state (&(this->state), &(this->lane[0]));
+    this->_lane_id (&(this->lane[0]), this->blk);
+    this->cur = &(this->lane[0]);
+    this->open = 1;
+  }
+  this->blk++;
+}
+
+/* closes lane l and XORs it into s */
+void Norx::_merge (state_t* l, state_t* s) {
+  this->_inject (l, NORX_TAG_MERGE);
+  this->_permute (l, this->rounds);
+  this->_fold (l, s);
+}
+
+void Norx::_fold (state_t* l, state_t* s) {
+  uint8_t i;
+  for (i=0;i<16;i++) this->_xor_word (s, i, this->_word (l, i));
+}
+
+void Norx::_merge_lanes (void) {
+  uint8_t i;
+  if (this->d) {
+    this->empty_state (this->state.bits, &(this->state));
+    for (i=0;i<this->d;i++) this->_merge (&(this->lane[i]), &(this->state));
+  } else {
+    if (this->open) this->_merge (&(this->lane[0]), &(this->lane[1]));
+    this->copy_state (&(this->lane[1]), &(this->state));
+  }
+  memset (this->lane, 0, sizeof(this->lane));
+  this->cur = &(this->state);
+  this->open = 0;
+  this->blk = 0;
+}
+
+/* one full payload block through lane s */
+void Norx::_block (state_t* s, uint8_t* out, const uint8_t* in, uint8_t mode) {
+  this->_inject (s, NORX_TAG_PAYLOAD);
+  this->_permute (s, this->rounds);
+  this->_rate_block (s, out, in, mode);
+}
+
+#if NORX_THREADS
+typedef struct {
+  Norx*          norx;
+  uint8_t*       out;
+  const uint8_t* in;
+  size_t         n;
+  size_t         blk;
+  uint8_t        mode;
+  uint8_t        tasks;
+  state_t        acc[NORX_MAX_LANES];
+} norx_bulk_t;
+
+/* task i of a fixed D run, the blocks of lane i */
+void Norx::_bulk_lane (void* arg, uint8_t i) {
+  norx_bulk_t* b = (norx_bulk_t*)arg;
+  Norx* x = b->norx;
+  uint8_t rate = 10 * (x->state.bits >> 3);
+  size_t j = (x->d - (b->blk % x->d) + i) % x->d;
+  for (;j<b->n;j+=x->d)
+    x->_block (&(x->lane[i]), b->out + j*rate, b->in + j*rate, b->mode);
+}
+
+/* task i of a D=0 run, every tasks-th block, merged into acc[i] */
+void Norx::_bulk_blocks (void* arg, uint8_t i) {
+  norx_bulk_t* b = (norx_bulk_t*)arg;
+  Norx* x = b->norx;
+  uint8_t rate = 10 * (x->state.bits >> 3);
+  state_t l;
+  size_t j;
+  x->empty_state (x->state.bits, &(b->acc[i]));
+  for (j=i;j<b->n;j+=b->tasks) {
+    x->copy_state (&(x->state), &l);
+    x->_lane_id (&l, b->blk + j);
+    x->_block (&l, b->out + j*rate, b->in + j*rate, b->mode);
+    x->_merge (&l, &(b->acc[i]));
+  }
+  memset (&l, 0, sizeof(l));
+}
+#endif
+
+/* n full payload blocks spread over the thread pool, from a block boundary */
+void Norx::_bulk (uint8_t* out, const uint8_t* in, size_t n, uint8_t mode) {
+#if NORX_THREADS
+  norx_bulk_t b;
+  uint8_t i, j;
+
+  if (!this->blk) this->_branch ();
+  b.norx = this;
+  b.out = out;
+  b.in = in;
+  b.n = n;
+  b.blk = this->blk;
+  b.mode = mode;
+  if (this->d) {
+    norx_pool_run (Norx::_bulk_lane, &b, this->d);
+    this->cur = &(this->lane[(this->blk + n - 1) % this->d]);
+  } else {
+    if (this->open) this->_merge (&(this->lane[0]), &(this->lane[1]));
+    this->open = 0;
+    b.tasks = norx_pool_size ();
+    norx_pool_run (Norx::_bulk_blocks, &b, b.tasks);
+    for (i=0;i<b.tasks;i++)
+      for (j=0;j<16;j++) this->_xor_word (&(this->lane[1]), j, this->_word (&(b.acc[i]), j));
+  }
+  memset (b.acc, 0, sizeof(b.acc));
+  this->blk += n;
+#endif
+}
+
+uint8_t Norx::tag_size (void) {
+  return _tag_of (this->state.bits);
+}
+
+bool Norx::start (uint8_t bits, const uint8_t* key, const uint8_t* nonce) {
+  if (!_built_in (bits)) return 0;
+  NORX_PROBE_BEGIN (p);
+  this->_load (&(this->state), bits, key, nonce);
+  this->_init_F (&(this->state), this->rounds);
+  this->_start ();
+  NORX_PROBE_END (p, NORX_STAT_INIT);
+  return 1;
+}
+
+void Norx::_start (void) {
+  this->phase = 0;
+  this->pos = this->_rate (&(this->state));
+  this->used = 0;
+  this->blk = 0;
+  this->open = 0;
+  this->cur = &(this->state);
+}
+
+/***************************************************************************
+ * saved contexts
+ *
+ * header : magic, version, bits, rounds, d, phase, pos, used, open and blk
+ * on 4 bytes. the partial block needs nothing more, it is in the rate. the
+ * lanes follow the state only once the payload has branched
+ */
+
+static uint8_t _saved_lanes (uint8_t d, uint32_t blk) {
+  if ((d==1)||(!blk)) return 0;
+  return d ? d : 2;
+}
+
+size_t Norx::save (uint8_t* blob) {
+  uint8_t* p = blob;
+  uint8_t i, j, k, lanes, wb = this->state.bits >> 3;
+  state_t* s;
+  uint64_t v;
+  uint32_t crc;
+
+  *p++ = NORX_SAVE_MAGIC;
+  *p++ = NORX_SAVE_VERSION;
+  *p++ = this->state.bits;
+  *p++ = this->rounds;
+  *p++ = this->d;
+  *p++ = this->phase;
+  *p++ = this->pos;
+  *p++ = this->used;
+  *p++ = this->open;
+  for (i=0;i<4;i++) *p++ = (uint8_t)(this->blk >> (i*8));
+  lanes = _saved_lanes (this->d, this->blk);
+  for (i=0;i<=lanes;i++) {
+    s = i ? &(this->lane[i-1]) : &(this->state);
+    for (j=0;j<16;j++) {
+      v = this->_word (s, j);
+      for (k=0;k<wb;k++) *p++ = (uint8_t)(v >> (k*8));
+    }
+  }
+  crc = crc32 (0, blob, p - blob);
+  for (i=0;i<4;i++) *p++ = (uint8_t)(crc >> (i*8));
+  return p - blob;
+}
+
+uint8_t Norx::restore (const uint8_t* blob, size_t len) {
+  const uint8_t* p = blob + 13;
+  uint8_t i, j, k, lanes, wb, bits, d, phase, pos;
+  uint32_t blk = 0, crc = 0;
+  state_t* s;
+  uint64_t v;
+
+  if (len<NORX_SAVE_SIZE (NORX_MIN_BITS, 0)) return NORX_RESTORE_LENGTH;
+  if (blob[0]!=NORX_SAVE_MAGIC) return NORX_RESTORE_MAGIC;
+  if (blob[1]!=NORX_SAVE_VERSION) return NORX_RESTORE_VERSION;
+  bits = blob[2];
+  d = blob[4];
+  phase = blob[5];
+  pos = blob[6];
+  for (i=0;i<4;i++) blk |= (uint32_t)blob[9+i] << (i*8);
+  if (!_built_in (bits)) return NORX_RESTORE_PARAMS;
+  if ((d>NORX_MAX_LANES)||((d==0)&&(NORX_MAX_LANES<2))) return NORX_RESTORE_PARAMS;
+  if ((phase>NORX_TAG_FINAL)||(pos>_rate_of (bits))) return NORX_RESTORE_PARAMS;
+  lanes = (bits<32) ? 0 : _saved_lanes (d, blk);
+  if (len!=NORX_SAVE_SIZE (bits, lanes)) return NORX_RESTORE_LENGTH;
+  for (i=0;i<4;i++) crc |= (uint32_t)blob[len-4+i] << (i*8);
+  if (crc!=crc32 (0, blob, len-4)) return NORX_RESTORE_CRC;
+
+  this->state.bits = bits;
+  this->rounds = blob[3];
+  this->d = d;
+  this->phase = phase;
+  this->pos = pos;
+  this->used = blob[7];
+  this->open = blob[8];
+  this->blk = blk;
+  wb = bits >> 3;
+  for (i=0;i<=lanes;i++) {
+    s = i ? &(this->lane[i-1]) : &(this->state);
+    s->bits = bits;
+    for (j=0;j<16;j++) {
+      v = 0;
+      for (k=wb;k>0;k--) v = (v << 8) | p[k-1];
+      this->_set_word (s, j, v);
+      p += wb;
+    }
+  }
+  this->cur = &(this->state);
+  if (lanes) this->cur = &(this->lane[d ? (blk - 1) % d : 0]);
+  return NORX_RESTORE_OK;
+}
+
+/***************************************************************************
+ * keyed contexts
+ *
+ * everything before the nonce goes in is the same for every message under
+ * a key: constants, key words and the parameter word. prepare runs _setup
+ * once with a zero nonce, start then copies that template and only writes
+ * nonce words 1 and 2 before the F^R. the rounds and D of the instance at
+ * prepare time are kept in the context and used by every keyed start
+ */
+
+bool Norx::prepare (norx_key_t* ctx, uint8_t bits, const uint8_t* key) {
+  if (!this->_load (&(ctx->tmpl), bits, key, NULL)) return 0;
+  ctx->d = this->d;
+  return 1;
+}
+
+void Norx::wipe (norx_key_t* ctx) {
+  memset (ctx, 0, sizeof(norx_key_t));
+}
+
+void Norx::start (const norx_key_t* ctx, const uint8_t* nonce) {
+  NORX_PROBE_BEGIN (p);
+  this->rounds = ctx->tmpl.rounds;
+  this->d = ctx->d;
+  this->state = ctx->tmpl;
+  this->_nonce (&(this->state), nonce);
+  this->_init_F (&(this->state), this->rounds);
+  this->_start ();
+  NORX_PROBE_END (p, NORX_STAT_INIT);
+}
+
+bool Norx::header (const uint8_t* h, size_t len) {
+  if (!this->_phase (NORX_TAG_HEADER)) return 0;
+  this->_duplex (NULL, h, len, NORX_MODE_ABSORB);
+  return 1;
+}
+
+bool Norx::encrypt (uint8_t* c, const uint8_t* m, size_t len) {
+  if (!this->_phase (NORX_TAG_PAYLOAD)) return 0;
+  this->_duplex (c, m, len, NORX_MODE_ENCRYPT);
+  return 1;
+}
+
+bool Norx::decrypt (uint8_t* m, const uint8_t* c, size_t len) {
+  if (!this->_phase (NORX_TAG_PAYLOAD)) return 0;
+  this->_duplex (m, c, len, NORX_MODE_DECRYPT);
+  return 1;
+}
+
+bool Norx::trailer (const uint8_t* t, size_t len) {
+  if (!this->_phase (NORX_TAG_TRAILER)) return 0;
+  this->_duplex (NULL, t, len, NORX_MODE_ABSORB);
+  return 1;
+}
+
+bool Norx::header (const norx_seg_t* h, uint8_t n) {
+  if (!this->_phase (NORX_TAG_HEADER)) return 0;
+  while (n--) {
+    this->_duplex (NULL, h->p, h->len, NORX_MODE_ABSORB);
+    h++;
+  }
+  return 1;
+}
+
+bool Norx::encrypt (norx_seg_t* m, uint8_t n) {
+  if (!this->_phase (NORX_TAG_PAYLOAD)) return 0;
+  while (n--) {
+    this->_duplex (m->p, m->p, m->len, NORX_MODE_ENCRYPT);
+    m++;
+  }
+  return 1;
+}
+
+bool Norx::decrypt (norx_seg_t* c, uint8_t n) {
+  if (!this->_phase (NORX_TAG_PAYLOAD)) return 0;
+  while (n--) {
+    this->_duplex (c->p, c->p, c->len, NORX_MODE_DECRYPT);
+    c++;
+  }
+  return 1;
+}
+
+bool Norx::trailer (const norx_seg_t* t, uint8_t n) {
+  if (!this->_phase (NORX_TAG_TRAILER)) return 0;
+  while (n--) {
+    this->_duplex (NULL, t->p, t->len, NORX_MODE_ABSORB);
+    t++;
+  }
+  return 1;
+}
+
+/* finalizes and writes tag_size() bytes, the state is wiped afterwards */
+void Norx::tag (uint8_t* t) {
+  uint8_t i, len = this->tag_size ();
+  this->_phase (NORX_TAG_FINAL);
+  NORX_PROBE_BEGIN (p);
+  this->_inject (&(this->state), NORX_TAG_FINAL);
+  this->_permute (&(this->state), this->rounds);
+  this->_permute (&(this->state), this->rounds);
+  NORX_TRACE (&(this->state), "final ");
+  for (i=0;i<len;i++)
+    t[i] = *(this->_rate_byte (&(this->state), i));
+  this->empty_state (this->state.bits, &(this->state));
+  NORX_PROBE_END (p, NORX_STAT_FINAL);
+}
+
+/* constant time comparison of the computed tag with t */
+bool Norx::verify (const uint8_t* t) {
+  uint8_t e[NORX_MAX_TAG_SIZE];
+  uint8_t i, len = this->tag_size ();
+  uint8_t d = 0;
+  this->tag (e);
+  for (i=0;i<len;i++)
+    d |= e[i] ^ t[i];
+  memset (e, 0, sizeof(e));
+  d = (1 & ((d - 1) >> 8));
+  NORX_CT_PUBLIC (&d, 1);
+  return d;
+}
+
+/* c receives mlen bytes of ciphertext followed by the tag */
+bool Norx::encrypt (uint8_t bits, const uint8_t* key, const uint8_t* nonce,
+                    const uint8_t* h, size_t hlen, const uint8_t* m, size_t mlen,
+                    const uint8_t* t, size_t tlen, uint8_t* c) {
+  if (!this->start (bits, key, nonce)) return 0;
+  this->_encrypt (h, hlen, m, mlen, t, tlen, c);
+  return 1;
+}
+
+void Norx::encrypt (const norx_key_t* ctx, const uint8_t* nonce,
+                    const uint8_t* h, size_t hlen, const uint8_t* m, size_t mlen,
+                    const uint8_t* t, size_t tlen, uint8_t* c) {
+  this->start (ctx, nonce);
+  this->_encrypt (h, hlen, m, mlen, t, tlen, c);
+}
+
+void Norx::_encrypt (const uint8_t* h, size_t hlen, const uint8_t* m, size_t mlen,
+                     const uint8_t* t, size_t tlen, uint8_t* c) {
+  this->header (h, hlen);
+  this->encrypt (c, m, mlen);
+  this->trailer (t, tlen);
+  this->tag (c + mlen);
+}
+
+/* clen includes the tag, m is zeroed if the tag does not match */
+bool Norx::decrypt (uint8_t bits, const uint8_t* key, const uint8_t* nonce,
+                    const uint8_t* h, size_t hlen, const uint8_t* c, size_t clen,
+                    const uint8_t* t, size_t tlen, uint8_t* m) {
+  if (clen<(size_t)_tag_of (bits)) return 0;
+  if (!this->start (bits, key, nonce)) return 0;
+  return this->_decrypt (h, hlen, c, clen, t, tlen, m);
+}
+
+bool Norx::decrypt (const norx_key_t* ctx, const uint8_t* nonce,
+                    const uint8_t* h, size_t hlen, const uint8_t* c, size_t clen,
+                    const uint8_t* t, size_t tlen, uint8_t* m) {
+  if (clen<(size_t)_tag_of (ctx->tmpl.bits)) return 0;
+  this->start (ctx, nonce);
+  return this->_decrypt (h, hlen, c, clen, t, tlen, m);
+}
+
+void Norx::encrypt (const norx_key_t* ctx, const uint8_t* nonce,
+                    const norx_seg_t* h, uint8_t hn, norx_seg_t* m, uint8_t mn,
+                    const norx_seg_t* t, uint8_t tn, uint8_t* tag) {
+  this->start (ctx, nonce);
+  this->header (h, hn);
+  this->encrypt (m, mn);
+  this->trailer (t, tn);
+  this->tag (tag);
+}
+
+bool Norx::decrypt (const norx_key_t* ctx, const uint8_t* nonce,
+                    const norx_seg_t* h, uint8_t hn, norx_seg_t* c, uint8_t cn,
+                    const norx_seg_t* t, uint8_t tn, const uint8_t* tag) {
+  uint8_t i;
+  this->start (ctx, nonce);
+  this->header (h, hn);
+  this->decrypt (c, cn);
+  this->trailer (t, tn);
+  if (this->verify (tag)) return 1;
+  for (i=0;i<cn;i++) memset (c[i].p, 0, c[i].len);
+  return 0;
+}
+
+bool Norx::_decrypt (const uint8_t* h, size_t hlen, const uint8_t* c, size_t clen,
+                     const uint8_t* t, size_t tlen, uint8_t* m) {
+  size_t mlen = clen - this->tag_size ();
+  this->header (h, hlen);
+  this->decrypt (m, c, mlen);
+  this->trailer (t, tlen);
+  if (this->verify (c + mlen)) return 1;
+  memset (m, 0, mlen);
+  return 0;
 }
 
 /***************************************************************************
@@ -214,27 +1036,69 @@ void Norx::_init (state_t* s, uint8_t w, uint8_t r, uint8_t d, uint8_t a, stw k[
  */
 
 void Norx::dump_state_word (uint8_t bits, stw* w) {
-  if ((bits&0x7f)==32) print_32_bits(w->b32);
-  if ((bits&0x7f)==64) print_64_bits(w->b64);
+  char b[5];
+  if (bits<32) {
+    hex_write_word (bits, b, w->b32);
+    b[bits>>2] = 0;
+    Serial.print (b);
+  }
+  if (bits==32) print_32_bits(w->b32);
+  if (bits==64) print_64_bits(w->b64);
 }
 
 void Norx::empty_state (uint8_t bits, state_t* s) {
+  memset (s, 0, sizeof(state_t));
   s->bits = bits;
-  s->rounds = 0;
-  for (uint8_t i=0; i<16; i++) { 
-    if (bits==32) s->state[i].b32 = 0x0;
-    if (bits==64) s->state[i].b64 = 0x0;
+}
+
+void Norx::prgm_copy_state_word (uint8_t bits, void* s, stw* d) {
+  if (bits==32) d->b32 = pgm_read_dword ((uint32_t*)(s));
+  if (bits==64) {
+    uint32_t v;
+    v = pgm_read_dword (((uint32_t*)(s))+1);
+    d->b64 = v;
+    d->b64 <<= 32;
+    v = pgm_read_dword ((uint32_t*)(s));
+    d->b64 |= v;
+  }
+}
+
+/* word i of the state at p, in flash */
+void Norx::_prgm_word (uint8_t bits, const void* p, uint8_t i, stw* w) {
+  if (bits==32) this->prgm_copy_state_word (bits, (void*)(((const uint32_t*)p) + i), w);
+  if (bits==64) this->prgm_copy_state_word (bits, (void*)(((const uint64_t*)p) + i), w);
+}
+
+void Norx::prgm_copy_state (uint8_t bits, const void* p, state_t* d) {
+  uint8_t i;
+  stw w;
+  d->bits = bits;
+  for (i=0;i<16;i++) {
+    this->_prgm_word (bits, p, i, &w);
+    this->_set_word (d, i, (bits==32) ? w.b32 : w.b64);
   }
 }
 
 void Norx::dump_state (state_t* s, char* prefix) {
+  this->_dump (s->bits, s, NULL, prefix);
+}
+
+/* a state in flash, printed as it is read */
+void Norx::dump_prgm_state (uint8_t bits, const void* p, char* prefix) {
+  this->_dump (bits, NULL, p, prefix);
+}
+
+void Norx::_dump (uint8_t bits, state_t* s, const void* p, char* prefix) {
+  stw w;
   for (uint8_t i=0;i<16;i++) {
     if (i==0)
       Serial.print (prefix);
     else if ((i%4)==0)
       for (uint8_t j=0; j<strlen(prefix);j++)
         Serial.print(' ');
-    this->dump_state_word(s->bits, &(s->state[i]));
+    if (s) w.b64 = this->_word (s, i);
+    else this->_prgm_word (bits, p, i, &w);
+    this->dump_state_word(bits, &w);
     if ((i%4)==3) 
       Serial.println();
     else
@@ -253,38 +1117,196 @@ void Norx::copy_state_word (uint8_t bits, stw* s, stw* d) {
 }
 
 void Norx::copy_state (state_t* s, state_t* d) {
-  uint8_t i;
   d->bits = s->bits;
-  /* bit 7 is used to tell if state is initializing */
-  for (i=0;i<16;i++) 
-    this->copy_state_word ((s->bits&0x7F), &(s->state[i]), &(d->state[i]));
+#if NORX_SMALL
+  if (s->bits==8) d->s8 = s->s8;
+  if (s->bits==16) d->s16 = s->s16;
+#endif
+  if (s->bits==32) d->s32 = s->s32;
+#if NORX_64
+  if (s->bits==64) d->s64 = s->s64;
+#endif
 }
 
 bool Norx::compare_state_word (uint8_t bits, stw* wa, stw* wb) {
   if (bits==32) return (wa->b32)==(wb->b32);
   if (bits==64) return (wa->b64)==(wb->b64);
+  return 0;
+}
+
+/* word i of s at any width, wider values are truncated */
+uint64_t Norx::_word (state_t* s, uint8_t i) {
+#if NORX_64
+  if (s->bits==64) return s->s64.w[i];
+#endif
+#if NORX_SMALL
+  if (s->bits==8) return s->s8.w[i];
+  if (s->bits==16) return s->s16.w[i];
+#endif
+  return s->s32.w[i];
+}
+
+void Norx::_set_word (state_t* s, uint8_t i, uint64_t v) {
+#if NORX_64
+  if (s->bits==64) { s->s64.w[i] = v; return; }
+#endif
+#if NORX_SMALL
+  if (s->bits==8) { s->s8.w[i] = (uint8_t)v; return; }
+  if (s->bits==16) { s->s16.w[i] = (uint16_t)v; return; }
+#endif
+  s->s32.w[i] = (uint32_t)v;
+}
+
+void Norx::_xor_word (state_t* s, uint8_t i, uint64_t v) {
+#if NORX_64
+  if (s->bits==64) { s->s64.w[i] ^= v; return; }
+#endif
+#if NORX_SMALL
+  if (s->bits==8) { s->s8.w[i] ^= (uint8_t)v; return; }
+  if (s->bits==16) { s->s16.w[i] ^= (uint16_t)v; return; }
+#endif
+  s->s32.w[i] ^= (uint32_t)v;
+}
+
+void Norx::trace (norx_trace_sink_t sink) {
+  this->sink = sink;
 }
 
+#if NORX_STATS
+const norx_stats_t* Norx::stats (void) {
+  return &(this->stat);
+}
+
+void Norx::stats_reset (void) {
+  memset (&(this->stat), 0, sizeof(this->stat));
+}
+#endif
+
+void Norx::_trace (state_t* s, char* label) {
+  if (this->sink) this->sink (s, label);
+  else this->dump_state (s, label);
+}
+
+/* constant time, every byte is looked at whatever the first difference */
 bool Norx::compare_state (state_t* sa, state_t* sb) {
-  uint8_t i, c = 0;
+  const uint8_t* a = (const uint8_t*)&(sa->s32);
+  const uint8_t* b = (const uint8_t*)&(sb->s32);
+  size_t i, len = sizeof(state32_t);
+  uint8_t d = 0;
   if (sa->bits!=sb->bits)
     return 0;
-  for(i=0;i<16;i++)
-    if (this->compare_state_word (sa->bits, &(sa->state[i]), &(sb->state[i])))
-      c++;
-  return (c==16); 
+#if NORX_64
+  if (sa->bits==64) len = sizeof(state64_t);
+#endif
+#if NORX_SMALL
+  if (sa->bits==8) len = sizeof(state8_t);
+  if (sa->bits==16) len = sizeof(state16_t);
+#endif
+  for (i=0;i<len;i++)
+    d |= a[i] ^ b[i];
+  d = (1 & ((d - 1) >> 8));
+  NORX_CT_PUBLIC (&d, 1);
+  return d;
+}
+
+/***************************************************************************
+ * power-on self test
+ *
+ * for each width built in, from the words 0 to 15 : NORX_POST_CHAIN
+ * chained F^4 and a CRC-32 of the state, then a one block AEAD at R 4 D 1,
+ * its ciphertext and tag checked by CRC-32 and decrypted back. a fixed 64
+ * rounds per width and nothing printed, so that setup () can afford it.
+ * the digests come from host/kat/genkat.py --post. the stream in progress,
+ * if any, is lost
+ */
+
+#define NORX_POST_CHAIN 8
+
+typedef struct {
+  uint8_t bits;
+  uint32_t perm;
+  uint32_t aead;
+} norx_post_t;
+
+const norx_post_t NORX_POST[] PROGMEM = {
+#if NORX_SMALL
+  {  8, 0x148bad23UL, 0xdda2ea97UL },
+  { 16, 0xea384f28UL, 0x740428f3UL },
+#endif
+  { 32, 0x4b0ebd2fUL, 0xf65bb893UL },
+#if NORX_64
+  { 64, 0xfc538a2bUL, 0x60f2820eUL },
+#endif
+};
+
+bool Norx::post (void) {
+  uint8_t key[32], nonce[16];
+  uint8_t b[10*(NORX_MAX_BITS>>3)+NORX_MAX_TAG_SIZE];
+  uint8_t saved_r = this->rounds, saved_d = this->d;
+  uint8_t bits, rate, tlen, i, j, k;
+  uint32_t crc;
+  uint64_t v;
+  bool ok = 1;
+
+  for (i=0;i<32;i++) key[i] = i;
+  for (i=0;i<16;i++) nonce[i] = 0x80 + i;
+  this->rounds = 4;
+  this->d = 1;
+  for (k=0;k<sizeof(NORX_POST)/sizeof(norx_post_t);k++) {
+    bits = pgm_read_byte (&(NORX_POST[k].bits));
+    this->state.bits = bits;
+    for (i=0;i<16;i++) this->_set_word (&(this->state), i, i);
+    for (i=0;i<NORX_POST_CHAIN;i++) this->_permute (&(this->state), 4);
+    crc = 0;
+    for (i=0;i<16;i++) {
+      v = this->_word (&(this->state), i);
+      for (j=0;j<(bits>>3);j++) b[j] = v >> (8*j);
+      crc = crc32 (crc, b, bits>>3);
+    }
+    ok &= (crc==pgm_read_dword (&(NORX_POST[k].perm)));
+
+    rate = _rate_of (bits);
+    tlen = _tag_of (bits);
+    for (i=0;i<rate;i++) b[i] = i * 7;
+    this->encrypt (bits, key, nonce, NULL, 0, b, rate, NULL, 0, b);
+    ok &= (crc32 (0, b, rate+tlen)==pgm_read_dword (&(NORX_POST[k].aead)));
+    ok &= this->decrypt (bits, key, nonce, NULL, 0, b, rate+tlen, NULL, 0, b);
+    for (i=0;i<rate;i++) ok &= (b[i]==(uint8_t)(i * 7));
+  }
+  this->rounds = saved_r;
+  this->d = saved_d;
+  return ok;
 }
 
+#if NORX_DIAG
 /***************************************************************************
- * test procedure
+ * test procedure, the verbose diagnostic build
  */
 
 bool Norx::test (void) {
-  //if (!test_cryptoutils()) return 0;
+  if (!test_cryptoutils()) return 0;
+  Serial.println (F("* Testing post"));
+  if (!_TEST (this->post ())) return 0;
   //if (!this->_test_32()) return 0;
   //if (!this->_test_64()) return 0;
+  if (!this->_test_G(32)) return 0;
+  if (!this->_test_G(64)) return 0;
   if (!this->_test_F()) return 0;
   if (!this->_test_init()) return 0;
+  if (!this->_test_aead()) return 0;
+  if (!this->_test_parallel()) return 0;
+  if (!this->_test_keyed()) return 0;
+  if (!this->_test_inplace()) return 0;
+  if (!this->_test_save()) return 0;
+#if NORX_SMALL
+  if (!this->_test_small()) return 0;
+#endif
+#if NORX_64
+  if (!this->_test_bi64()) return 0;
+#endif
+#if NORX_STATS
+  if (!this->_test_stats()) return 0;
+#endif
   return 1;
 }
 
@@ -309,6 +1331,7 @@ bool Norx::_test_64 (void) {
   if (!this->_test_ADX(64)) return 0;
   if (!this->_test_XRL(64)) return 0;
   if (!this->_test_G(64)) return 0;
+  return 1;
 }
 
 const char _TEST_A_STR_32[] = "12345678";
@@ -323,7 +1346,7 @@ bool Norx::_test_load_state_word_from_hex (uint8_t bits) {
   stw ea;
   if (bits==32) ea.b32 = _TEST_A_32.b32;
   if (bits==64) ea.b64 = _TEST_A_64.b64;
-  Serial.print ("* Testing load_state_word_from_hex");
+  Serial.print (F("* Testing load_state_word_from_hex"));
   Serial.println (bits);
   this->dump_state_word (bits, &ea);
   Serial.println ();
@@ -354,10 +1377,11 @@ bool Norx::_test_XOR (uint8_t bits) {
   stw ew, w, a, b;
 
   this->__test_load_a_b(bits, &a, &b);
-  Serial.print ("* Testing XOR_");
+  Serial.print (F("* Testing XOR_"));
   Serial.println (bits);
   if (bits==32) ew.b32 = 0x317131f1;
-  if (bits==64) ew.b64 = 0x317131f1317131f1;
+  if (bits==64) ew.b64 = 0x317131f1317131f1
+;
   this->dump_state_word (bits,&ew);
   Serial.println();
   if (bits==32) this->_XOR_32 (&w, &a, &b);
@@ -371,10 +1395,11 @@ bool Norx::_test_AND (uint8_t bits) {
   stw ew, w, a, b;
 
   this->__test_load_a_b(bits, &a, &b);
-  Serial.print ("* Testing AND_");
+  Serial.print (F("* Testing AND_"));
   Serial.println (bits);
   if (bits==32) ew.b32 = 0x02044608;
-  if (bits==64) ew.b64 = 0x020446088a8cce00;
+  if (bits==64) ew.b64 = 0x020446088a8cce00
+;
   this->dump_state_word (bits, &ew);
   Serial.println();
   if (bits==32) this->_AND_32 (&w, &a, &b);
@@ -388,10 +1413,11 @@ bool Norx::_test_SHL (uint8_t bits) {
   stw ew, w, a;
 
   this->__test_load_a(bits, &a);
-  Serial.print ("* Testing SHL_");
+  Serial.print (F("* Testing SHL_"));
   Serial.println (bits);
   if (bits==32) ew.b32 = 0x1a2b3c00;
-  if (bits==64) ew.b64 = 0x1a2b3c4d5e6f7800;
+  if (bits==64) ew.b64 = 0x1a2b3c4d5e6f7800
+;
   this->dump_state_word (bits, &ew);
   Serial.println();
   if (bits==32) this->_SHL_32 (&w, &a, 7);
@@ -405,10 +1431,11 @@ bool Norx::_test_ROR (uint8_t bits) {
   stw ew, w, a;
 
   this->__test_load_a(bits, &a);
-  Serial.print ("* Testing ROR_");
+  Serial.print (F("* Testing ROR_"));
   Serial.println (bits);
   if (bits==32) ew.b32 = 0xb3c091a2;
-  if (bits==64) ew.b64 = 0xf78091a2b3c4d5e6;
+  if (bits==64) ew.b64 = 0xf78091a2b3c4d5e6
+;
   this->dump_state_word (bits, &ew);
   Serial.println();
   if (bits==32) this->_ROR_32 (&w, &a, 13);
@@ -422,10 +1449,11 @@ bool Norx::_test_ADX (uint8_t bits) {
   stw ew, w, a, b;
 
   this->__test_load_a_b(bits, &a, &b);
-  Serial.print ("* Testing ADX_");
+  Serial.print (F("* Testing ADX_"));
   Serial.println (bits);
   if (bits==32) ew.b32 = 0x3579bde1;
-  if (bits==64) ew.b64 = 0x3579bde02468adf1;
+  if (bits==64) ew.b64 = 0x3579bde02468adf1
+;
   this->dump_state_word (bits, &ew);
   Serial.println();
   if (bits==32) this->_ADX_32 (&w, &a, &b);
@@ -439,7 +1467,7 @@ bool Norx::_test_XRL (uint8_t bits) {
   stw ew, w, a, b;
 
   this->__test_load_a_b(bits, &a, &b);
-  Serial.print ("* Testing XRL_");
+  Serial.print (F("* Testing XRL_"));
   Serial.println (bits);
   if (bits==32) ew.b32 = 0x3e262e26;
   this->dump_state_word (bits, &ew);
@@ -479,6 +1507,7 @@ const uint32_t G_TEST_RESULTS_32[][4] PROGMEM = {
   { 0xB7BF8099, 0x65A6E720, 0x1E22F5Cb, 0x1AA9E143 }
 };
 
+#define G_NB_TEST_VECTORS_64 11
 const uint64_t G_TEST_VECTORS_64[][4] PROGMEM = {
   { 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000 },
   { 0x0000000000000001, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000 },
@@ -506,21 +1535,9 @@ const uint64_t G_TEST_RESULTS_64[][4] PROGMEM = {
   { 0x06E0F91F53B5CA4B, 0x1D4225AFF0B8887D, 0x26541088639A5752, 0x5A343C6186E9E1DA }
 };
 
-void Norx::prgm_copy_state_word (uint8_t bits, void* s, stw* d) {
-  if (bits==32) d->b32 = pgm_read_dword ((uint32_t*)(s));
-  if (bits==64) {
-    uint32_t v;
-    v = pgm_read_dword (((uint32_t*)(s))+1);
-    d->b64 = v;
-    d->b64 <<= 32;
-    v = pgm_read_dword ((uint32_t*)(s));
-    d->b64 |= v;
-  }
-}
-
 bool Norx::_test_G_one (uint8_t bits, uint8_t idx) {
   uint8_t i;
-  stw w[4], e[4];
+  stw w[4], v[4], e[4];
   
   if (bits==32) {
     uint32_t* vec32 = (uint32_t*)G_TEST_VECTORS_32;
@@ -539,34 +1556,52 @@ bool Norx::_test_G_one (uint8_t bits, uint8_t idx) {
     }
   }
   
-  Serial.print ("vec ");
+  Serial.print (F("vec "));
   for (i=0;i<4;i++) {
     this->dump_state_word (bits, &(w[i]));
     Serial.print (' ');
   }
   Serial.println ();
   
+  for (i=0;i<4;i++)
+    this->copy_state_word (bits, &(w[i]), &(v[i]));
+
+  // reference G
   if (bits==32) this->__G_32 (&(w[0]), &(w[1]), &(w[2]), &(w[3]));
   if (bits==64) this->__G_64 (&(w[0]), &(w[1]), &(w[2]), &(w[3]));
+  // specialized core G
+  if (bits==32) Norx32F::G (v[0].b32, v[1].b32, v[2].b32, v[3].b32);
+  if (bits==64) Norx64F::G (v[0].b64, v[1].b64, v[2].b64, v[3].b64);
 
-  Serial.print ("exp ");
+  Serial.print (F("exp "));
   for (i=0;i<4;i++) {
     this->dump_state_word (bits, &(e[i]));
     Serial.print (' ');
   }
   Serial.println ();
 
-  Serial.print ("res ");
+  Serial.print (F("res "));
   for (i=0;i<4;i++) {
     this->dump_state_word (bits, &(w[i]));
     Serial.print (' ');
   }
   Serial.println ();
 
-  return _TEST (this->compare_state_word(bits, &(w[0]), &(e[0])) | \
-                this->compare_state_word(bits, &(w[1]), &(e[1])) | \
-                this->compare_state_word(bits, &(w[2]), &(e[2])) | \
-                this->compare_state_word(bits, &(w[3]), &(e[3])));
+  Serial.print (F("cor "));
+  for (i=0;i<4;i++) {
+    this->dump_state_word (bits, &(v[i]));
+    Serial.print (' ');
+  }
+  Serial.println ();
+
+  return _TEST (this->compare_state_word(bits, &(w[0]), &(e[0])) & \
+                this->compare_state_word(bits, &(w[1]), &(e[1])) & \
+                this->compare_state_word(bits, &(w[2]), &(e[2])) & \
+                this->compare_state_word(bits, &(w[3]), &(e[3])) & \
+                this->compare_state_word(bits, &(v[0]), &(e[0])) & \
+                this->compare_state_word(bits, &(v[1]), &(e[1])) & \
+                this->compare_state_word(bits, &(v[2]), &(e[2])) & \
+                this->compare_state_word(bits, &(v[3]), &(e[3])));
 }
 
 bool Norx::_test_G (uint8_t bits) {
@@ -576,155 +1611,210 @@ bool Norx::_test_G (uint8_t bits) {
   uint8_t nbvec;
   
   if (bits==32) { nbvec=G_NB_TEST_VECTORS_32; }
+  if (bits==64) { nbvec=G_NB_TEST_VECTORS_64; }
     
-  Serial.println ("* Testing G");
+  Serial.println (F("* Testing G"));
   for (i=0;i<nbvec;i++)
     if (this->_test_G_one (bits, i))
       c++;
   Serial.print (nbvec);
-  Serial.print (" tests done, ");
+  Serial.print (F(" tests done, "));
   Serial.print (c);
-  Serial.println (" tests successful");
+  Serial.println (F(" tests successful"));
   return _TEST (c==nbvec);
 }
 
-const state_t F_TEST_VECTORS[] PROGMEM = {
-  { 0xa0, 0x01, 
-          { 0x00000001, 0x00000000, 0x00000000, 0x00000000,
-            0x00000000, 0x00000000, 0x00000000, 0x00000000,
-            0x00000000, 0x00000000, 0x00000000, 0x00000000,
-            0x00000000, 0x00000000, 0x00000000, 0x00000000 } },
-  { 0x20, 0x01,
-          { 0x04004001, 0x20200400, 0x20042020, 0x4A4A8A08,
-            0x01880885, 0x8A424A40, 0x4A024A02, 0xC24A0248,
-            0x41212104, 0x888C4C4A, 0x41210520, 0x05212101,
-            0x05012000, 0x20202004, 0x884A4A08, 0x40210500 } },
-  { 0x20, 0x01,
-          { 0xEFDB6055, 0x4EB0C8FD, 0x4D66BAD5, 0xA5716F6F,
-            0x3315BA06, 0xB5E09122, 0x44A18E71, 0x51E36297,
-            0xF137B870, 0x3C7265F6, 0x00C30D5B, 0x295A09AA,
-            0xB42B85E7, 0xAC007723, 0x742077A7, 0x4BADCF9B } },
-  { 0x20, 0x01,
-          { 0xB49E8FA1, 0xB87AED22, 0x86152D27, 0xBEB398AD,
-            0xBD48EB80, 0x1D4447DA, 0xB7458BA9, 0xA9E9EF9B,
-            0xF7599C6A, 0x203FB309, 0x694A1283, 0xC4875743,
-            0xF4E78B62, 0x50BE8206, 0x7BEF5DF7, 0xF92F6B9C } },
-  { 0x20, 0x01,
-          { 0xD8936EA9, 0x4FDFA7F9, 0x2E23D116, 0xED7C3692,
-            0x3E463C40, 0xA5AA5D55, 0xA05A6E11, 0xD22C7D58,
-            0x3C0D461D, 0x5D78E74F, 0x88C9121B, 0xECA4CA13,
-            0xE12928CB, 0x0167E06D, 0x90E1494E, 0x7CBBCCDA } },
-  { 0x20, 0x01,
-          { 0xDC4D4AE5, 0x2EA22D30, 0x0F46317D, 0x61B76178,
-            0x317CF942, 0xAA617101, 0xB1B646B0, 0x9FB8201C,
-            0x31E77E87, 0x0E87682D, 0xAB27674A, 0x1C00EF33,
-            0x49676DA0, 0x5E36BB3F, 0x369CB43A, 0xF6E575E8 } },
-  { 0x20, 0x01, 
-          { 0x472112C6, 0xEBBA21DD, 0x69FAF1B0, 0x06AADA3C,
-            0x958968BA, 0xFAF43AF0, 0x8A346D6C, 0x04DAD629,
-            0x28C63C70, 0xF49BAA13, 0x57DE5F7C, 0x28841E18,
-            0xEA3F594F, 0x8D744A62, 0x57B54FF1, 0x753A4160 } },
-  { 0x20, 0x01,
-          { 0x865ACF57, 0x0B1CD341, 0x44571AAD, 0x1E351C75,
-            0x679AB711, 0x8D923CDC, 0x115DC180, 0xCF5E7435,
-            0x94D66EB3, 0x6B643DA7, 0xC71FD3A8, 0xEACD114A,
-            0xFE5A4582, 0x101A0A61, 0xDEF929CE, 0xF81307CE } },
-  { 0x20, 0x01,
-          { 0xEE830EF5, 0xEFEDB52C, 0xD9B5DDE0, 0x11699703,
-            0xA59F827F, 0xE7DA769E, 0x9ACF9688, 0xFE6B4EE6,
-            0x2D99EFFF, 0xC1F42728, 0x1B33FCE4, 0x2484C32D,
-            0x454DEF51, 0x65220E90, 0xD8B53023, 0x10265221 } },
-  { 0xc0, 0x01,
-          { 0x0000000000000001, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
-            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
-            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
-            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000 } },
-  { 0x40, 0x01,
-          { 0x0000004000000401, 0x2020000400000000, 0x2000042000000020, 0x42400888420A0840,
-            0x1008008580981891, 0x8240004842020800, 0x4800020A00420200, 0xC200084042420048,
-            0x4100000021210004, 0x8844080A80440408, 0x4120000421010000, 0x0420010100210100,
-            0x0400010100200000, 0x2000000020200004, 0x8802080A40420208, 0x4020000401010000 } },
-  { 0x40, 0x01,
-          { 0x9D802FD127A732A1, 0xBFDC94FCF7EDB4F6, 0x50E28C54A198AD0E, 0x09FCDB8FCCC9DDA8,
-            0x7ACEC81E5BAA6D25, 0x10C9CBCF5BFEFC27, 0x11A152F2C1A43FCA, 0x6BA77CCFA2D9F407,
-            0x0E03AD8E4F36AD96, 0xB405D697E680A2BB, 0x3651B1301374F05D, 0xEC2A3CD28E701034,
-            0xD793C96953AA22B3, 0x81B56FC8F78827DD, 0xA5F18C894182A861, 0xF95F620C599E1A7D } },
-  { 0x40, 0x01,
-          { 0x6D9C774FB118B930, 0x0AD4888256442919, 0xB2625AFA68288616, 0x3F682524B541B12D,
-            0x09FB30C77ED1253C, 0xD276B00A56FA3BB2, 0xD1A3ED2B432628E0, 0x59DE47C408703466,
-            0x730C85F6CF7CD9B4, 0xD731F331C620402D, 0x664456562656A61E, 0x10F001A72ABF1CCA,
-            0xE04F26164B84BCD5, 0xE1CE43EA4AC71790, 0xBE0A7BDA26AB8C3E, 0x083CB972BE746F0D } },
-  { 0x40, 0x01,
-          { 0x9AE671BAC4106A33, 0x2532A3AF80EB8C24, 0x8807B8748AAF89BB, 0xCCBD275D7AC0180C,
-            0x9E3C9A644E2EE2B1, 0x6EF830BF37A17BB2, 0xA56A3F09DA96ABC9, 0x6674A590854EA97D,
-            0xD58BFB1A8D2677C5, 0x5696D8DEA26A6D6D, 0x2E973803C96922A4, 0x9C8EC44641A390FD,
-            0xABE2F120F069F77A, 0x305FE9E02B725884, 0x1D2A9380316FE1A6, 0x8FA5B15C10F77415 } },
-  { 0x40, 0x01,
-          { 0xE7BC1BB342393A06, 0x4497F473D8AE5B3A, 0x238B885A51663B54, 0xFCFD9F88948D42A7,
-            0x5B6E332077A59C5D, 0xC798AA981789AC8D, 0xF916664458B5AD3F, 0xF7086A16B2407A56,
-            0x8DD6CEC45AC62D09, 0x2C217A7DC1AB282C, 0x8AA14855B8A7A065, 0x1BA096650A8E8F6D,
-            0x9ECAB9E7A91D59FE, 0xA57F363A65CF10D3, 0xF16FCED7A605DFE9, 0xC02D0A46B23E8C31 } },
-  { 0x40, 0x01,
-          { 0x2FCA68C9B1691627, 0x59E2B79D4B2A88F8, 0xD44A3CC624C9028F, 0x6295CCEC81F0F5AF,
-            0xAFBA11EEC8CE43A4, 0xA6BC58426BDAB6AC, 0xC9FA0754D15A38A6, 0x61B7C093B862D551,
-            0xB7A8A66A9227EE06, 0x17BEF1A5F98B7250, 0xCCAA13033F5ADCD3, 0x15CBCEF3A8A993B5,
-            0x2E321403DA39690B, 0xD805E663071507B0, 0x6D7EBAA185FF9F07, 0x64071C2C7A0205EA } },
-  { 0x40, 0x01,
-          { 0xBF643FF50F9B521B, 0xD6ECDEF9B9AC18B0, 0x29C44312EB0ED72A, 0x6AA97E4B4BF39E0A, 
-            0xA957D54C2B38DF1B, 0x23E4928A7504F6B8, 0x6CFEE0C2D418DC84, 0x10464EB477E6D548,
-            0x18A96DABB8BBC145, 0x406A6EE1C806F1E4, 0xA54BD0A7B7291B4A, 0x27BC2F8593DD77BE,
-            0x3BE8FF6116D7AFB0, 0x4D78AEB59B3A9C25, 0x9F03C664A44601DC, 0xDDBE9B34DA020E59 } },
-  { 0x40, 0x01,
-          { 0xF51507DD9E95189F, 0xAB5E0B1641FAD08F, 0x09B7BF70943B60DE, 0xE35D03636672DACD,
-            0x1D013C731A134DCD, 0x850FC95D9CA677C8, 0x48D78D3658CBE8D0, 0x3898A93514FBF49D,
-            0x8849E2B60F59D433, 0xA1C7E702A391D4B9, 0xC0057990DE07D3EE, 0x6BBF9A8B0E6CB108,
-            0x7DE67998BA91A9CE, 0x68F2B4BC4B8F6A52, 0x4EFE2C5711E64647, 0x27173B06EFB20807 } },
+/* F test vectors, entry 0 is the start state, entry i+1 is F applied to
+   entry i */
+const state32_t F_TEST_VECTORS_32[] PROGMEM = {
+  { {
+      0x00000001, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000
+  } },
+  { {
+      0x04004001, 0x20200400, 0x20042020, 0x4A4A8A08,
+      0x01880885, 0x8A424A40, 0x4A024A02, 0xC24A0248,
+      0x41212104, 0x888C4C4A, 0x41210520, 0x05212101,
+      0x05012000, 0x20202004, 0x884A4A08, 0x40210500
+  } },
+  { {
+      0xEFDB6055, 0x4EB0C8FD, 0x4D66BAD5, 0xA5716F6F,
+      0x3315BA06, 0xB5E09122, 0x44A18E71, 0x51E36297,
+      0xF137B870, 0x3C7265F6, 0x00C30D5B, 0x295A09AA,
+      0xB42B85E7, 0xAC007723, 0x742077A7, 0x4BADCF9B
+  } },
+  { {
+      0xB49E8FA1, 0xB87AED22, 0x86152D27, 0xBEB398AD,
+      0xBD48EB80, 0x1D4447DA, 0xB7458BA9, 0xA9E9EF9B,
+      0xF7599C6A, 0x203FB309, 0x694A1283, 0xC4875743,
+      0xF4E78B62, 0x50BE8206, 0x7BEF5DF7, 0xF92F6B9C
+  } },
+  { {
+      0xD8936EA9, 0x4FDFA7F9, 0x2E23D116, 0xED7C3692,
+      0x3E463C40, 0xA5AA5D55, 0xA05A6E11, 0xD22C7D58,
+      0x3C0D461D, 0x5D78E74F, 0x88C9121B, 0xECA4CA13,
+      0xE12928CB, 0x0167E06D, 0x90E1494E, 0x7CBBCCDA
+  } },
+  { {
+      0xDC4D4AE5, 0x2EA22D30, 0x0F46317D, 0x61B76178,
+      0x317CF942, 0xAA617101, 0xB1B646B0, 0x9FB8201C,
+      0x31E77E87, 0x0E87682D, 0xAB27674A, 0x1C00EF33,
+      0x49676DA0, 0x5E36BB3F, 0x369CB43A, 0xF6E575E8
+  } },
+  { {
+      0x472112C6, 0xEBBA21DD, 0x69FAF1B0, 0x06AADA3C,
+      0x958968BA, 0xFAF43AF0, 0x8A346D6C, 0x04DAD629,
+      0x28C63C70, 0xF49BAA13, 0x57DE5F7C, 0x28841E18,
+      0xEA3F594F, 0x8D744A62, 0x57B54FF1, 0x753A4160
+  } },
+  { {
+      0x865ACF57, 0x0B1CD341, 0x44571AAD, 0x1E351C75,
+      0x679AB711, 0x8D923CDC, 0x115DC180, 0xCF5E7435,
+      0x94D66EB3, 0x6B643DA7, 0xC71FD3A8, 0xEACD114A,
+      0xFE5A4582, 0x101A0A61, 0xDEF929CE, 0xF81307CE
+  } },
+  { {
+      0xEE830EF5, 0xEFEDB52C, 0xD9B5DDE0, 0x11699703,
+      0xA59F827F, 0xE7DA769E, 0x9ACF9688, 0xFE6B4EE6,
+      0x2D99EFFF, 0xC1F42728, 0x1B33FCE4, 0x2484C32D,
+      0x454DEF51, 0x65220E90, 0xD8B53023, 0x10265221
+  } },
 };
 
-void Norx::prgm_copy_state (state_t* s, state_t* d) {
-  uint8_t bits, i;
-  bits = pgm_read_byte ((uint8_t*)(&(s->bits)));
-  d->bits = bits;
-  bits &=0x7f;
-  for (i=0;i<16;i++) 
-    this->prgm_copy_state_word (bits, (void*)(&(s->state[i])), &(d->state[i]));
+#if NORX_64
+const state64_t F_TEST_VECTORS_64[] PROGMEM = {
+  { {
+      0x0000000000000001, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+      0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+      0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+      0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000
+  } },
+  { {
+      0x0000004000000401, 0x2020000400000000, 0x2000042000000020, 0x42400888420A0840,
+      0x1008008580981891, 0x8240004842020800, 0x4800020A00420200, 0xC200084042420048,
+      0x4100000021210004, 0x8844080A80440408, 0x4120000421010000, 0x0420010100210100,
+      0x0400010100200000, 0x2000000020200004, 0x8802080A40420208, 0x4020000401010000
+  } },
+  { {
+      0x9D802FD127A732A1, 0xBFDC94FCF7EDB4F6, 0x50E28C54A198AD0E, 0x09FCDB8FCCC9DDA8,
+      0x7ACEC81E5BAA6D25, 0x10C9CBCF5BFEFC27, 0x11A152F2C1A43FCA, 0x6BA77CCFA2D9F407,
+      0x0E03AD8E4F36AD96, 0xB405D697E680A2BB, 0x3651B1301374F05D, 0xEC2A3CD28E701034,
+      0xD793C96953AA22B3, 0x81B56FC8F78827DD, 0xA5F18C894182A861, 0xF95F620C599E1A7D
+  } },
+  { {
+      0x6D9C774FB118B930, 0x0AD4888256442919, 0xB2625AFA68288616, 0x3F682524B541B12D,
+      0x09FB30C77ED1253C, 0xD276B00A56FA3BB2, 0xD1A3ED2B432628E0, 0x59DE47C408703466,
+      0x730C85F6CF7CD9B4, 0xD731F331C620402D, 0x664456562656A61E, 0x10F001A72ABF1CCA,
+      0xE04F26164B84BCD5, 0xE1CE43EA4AC71790, 0xBE0A7BDA26AB8C3E, 0x083CB972BE746F0D
+  } },
+  { {
+      0x9AE671BAC4106A33, 0x2532A3AF80EB8C24, 0x8807B8748AAF89BB, 0xCCBD275D7AC0180C,
+      0x9E3C9A644E2EE2B1, 0x6EF830BF37A17BB2, 0xA56A3F09DA96ABC9, 0x6674A590854EA97D,
+      0xD58BFB1A8D2677C5, 0x5696D8DEA26A6D6D, 0x2E973803C96922A4, 0x9C8EC44641A390FD,
+      0xABE2F120F069F77A, 0x305FE9E02B725884, 0x1D2A9380316FE1A6, 0x8FA5B15C10F77415
+  } },
+  { {
+      0xE7BC1BB342393A06, 0x4497F473D8AE5B3A, 0x238B885A51663B54, 0xFCFD9F88948D42A7,
+      0x5B6E332077A59C5D, 0xC798AA981789AC8D, 0xF916664458B5AD3F, 0xF7086A16B2407A56,
+      0x8DD6CEC45AC62D09, 0x2C217A7DC1AB282C, 0x8AA14855B8A7A065, 0x1BA096650A8E8F6D,
+      0x9ECAB9E7A91D59FE, 0xA57F363A65CF10D3, 0xF16FCED7A605DFE9, 0xC02D0A46B23E8C31
+  } },
+  { {
+      0x2FCA68C9B1691627, 0x59E2B79D4B2A88F8, 0xD44A3CC624C9028F, 0x6295CCEC81F0F5AF,
+      0xAFBA11EEC8CE43A4, 0xA6BC58426BDAB6AC, 0xC9FA0754D15A38A6, 0x61B7C093B862D551,
+      0xB7A8A66A9227EE06, 0x17BEF1A5F98B7250, 0xCCAA13033F5ADCD3, 0x15CBCEF3A8A993B5,
+      0x2E321403DA39690B, 0xD805E663071507B0, 0x6D7EBAA185FF9F07, 0x64071C2C7A0205EA
+  } },
+  { {
+      0xBF643FF50F9B521B, 0xD6ECDEF9B9AC18B0, 0x29C44312EB0ED72A, 0x6AA97E4B4BF39E0A,
+      0xA957D54C2B38DF1B, 0x23E4928A7504F6B8, 0x6CFEE0C2D418DC84, 0x10464EB477E6D548,
+      0x18A96DABB8BBC145, 0x406A6EE1C806F1E4, 0xA54BD0A7B7291B4A, 0x27BC2F8593DD77BE,
+      0x3BE8FF6116D7AFB0, 0x4D78AEB59B3A9C25, 0x9F03C664A44601DC, 0xDDBE9B34DA020E59
+  } },
+  { {
+      0xF51507DD9E95189F, 0xAB5E0B1641FAD08F, 0x09B7BF70943B60DE, 0xE35D03636672DACD,
+      0x1D013C731A134DCD, 0x850FC95D9CA677C8, 0x48D78D3658CBE8D0, 0x3898A93514FBF49D,
+      0x8849E2B60F59D433, 0xA1C7E702A391D4B9, 0xC0057990DE07D3EE, 0x6BBF9A8B0E6CB108,
+      0x7DE67998BA91A9CE, 0x68F2B4BC4B8F6A52, 0x4EFE2C5711E64647, 0x27173B06EFB20807
+  } },
+};
+#endif
+
+/* F test vector i at the given width, 0 past the last one */
+const void* Norx::_prgm_vector (uint8_t bits, uint8_t i) {
+  if ((bits==32)&&(i<sizeof(F_TEST_VECTORS_32)/sizeof(state32_t)))
+    return &(F_TEST_VECTORS_32[i]);
+#if NORX_64
+  if ((bits==64)&&(i<sizeof(F_TEST_VECTORS_64)/sizeof(state64_t)))
+    return &(F_TEST_VECTORS_64[i]);
+#endif
+  return 0;
+}
+
+bool Norx::_test_vector (uint8_t bits, uint8_t i, state_t* s) {
+  const void* p = this->_prgm_vector (bits, i);
+  if (p) this->prgm_copy_state (bits, p, s);
+  return p!=0;
 }
 
-bool Norx::_test_F_one (uint8_t i, state_t* s) {
+/* the expected state is checked and printed straight from flash, a word at
+   a time, it is never copied to RAM */
+bool Norx::_test_F_one (uint8_t bits, uint8_t i, state_t* s, state_t* r) {
   char prefix[] = "f    ";
-  state_t e;
+  const void* p = this->_prgm_vector (bits, i);
+  bool ok = 1;
+  uint8_t j;
+  stw w;
   
-  Serial.print("F test vector ");
+  Serial.print(F("F test vector "));
+  Serial.print(bits);
+  Serial.print(' ');
   Serial.println(i);
-  this->prgm_copy_state((state_t*)&(F_TEST_VECTORS[i]),&e);
   
-  for(uint8_t i=0;i<40;i++)
+  for(j=0;j<40;j++)
     Serial.print('-');
   Serial.println();
 
-  if (e.bits&0x80) {
-    e.bits&=0x7f;
-    this->copy_state(&e, s);
-  } else
+  if (i==0) {
+    this->prgm_copy_state(bits, p, s);
+    this->copy_state(s, r);
+  } else {
     this->_F (s);
+    this->_F_ref (r);
+  }
   if (i<10) prefix[1] = 0x20;
   else prefix[1] = (i/10)+0x30;
   prefix[2] = (i%10)+0x30;
   this->dump_state(s,prefix);
   Serial.println();
-  this->dump_state(&e, "exp  ");
-  return _TEST (this->compare_state(s, &(e)));
+  this->dump_prgm_state(bits, p, "exp  ");
+  for (j=0;j<16;j++) {
+    this->_prgm_word (bits, p, j, &w);
+    if (bits==32) ok &= (this->_word (s, j)==w.b32) & (this->_word (r, j)==w.b32);
+    if (bits==64) ok &= (this->_word (s, j)==w.b64) & (this->_word (r, j)==w.b64);
+  }
+  return _TEST (ok);
 }
 
 bool Norx::_test_F (void) {
-  uint8_t i, c = 0, len;
-  state_t s;
+  uint8_t i, c = 0, len = 0;
+  state_t* s = &(this->state);
+  state_t* r = &(this->lane[0]);
   
-  len = sizeof(F_TEST_VECTORS)/sizeof(state_t);
-  // calculation loops
-  for (i=0; i<len; ++i)
-    if (this->_test_F_one(i, &s))
-      c++;  
+  // calculation loops, specialized core in the state, reference in lane 0,
+  // so that the test keeps no state on the stack
+  for (i=0; i<sizeof(F_TEST_VECTORS_32)/sizeof(state32_t); ++i, ++len)
+    if (this->_test_F_one(32, i, s, r))
+      c++;
+#if NORX_64
+  for (i=0; i<sizeof(F_TEST_VECTORS_64)/sizeof(state64_t); ++i, ++len)
+    if (this->_test_F_one(64, i, s, r))
+      c++;
+#endif
+  this->empty_state (32, s);
+  this->empty_state (32, r);
   return _TEST (c==len);
 }
 
@@ -747,3 +1837,438 @@ bool Norx::_test_init (void) {
   this->_init (&s, w, 4, 1, a, k, n, 0);
   return 1;
 }
+
+#define AEAD_TEST_MAX 81
+
+/* one shot vs 3 byte chunked streaming, round trip and forged tag */
+bool Norx::_test_aead_one (uint8_t bits, size_t mlen) {
+  const uint8_t h[] = "norx header";
+  const uint8_t t[] = "trailer";
+  uint8_t key[32], nonce[16];
+  uint8_t m[AEAD_TEST_MAX];
+  uint8_t c[AEAD_TEST_MAX+NORX_MAX_TAG_SIZE];
+  uint8_t s[AEAD_TEST_MAX+NORX_MAX_TAG_SIZE];
+  size_t i, n;
+  bool ok = 1;
+
+  for (i=0;i<32;i++) key[i] = i;
+  for (i=0;i<16;i++) nonce[i] = 0xf0 + i;
+  for (i=0;i<mlen;i++) m[i] = i * 7;
+
+  Serial.print (F("* Testing AEAD_"));
+  Serial.print (bits);
+  Serial.print (F(" len "));
+  Serial.print (mlen);
+  if (this->d!=1) {
+    Serial.print (F(" D "));
+    Serial.print (this->d);
+  }
+  Serial.println ();
+
+  this->encrypt (bits, key, nonce, h, sizeof(h)-1, m, mlen, t, sizeof(t)-1, c);
+
+  this->start (bits, key, nonce);
+  for (i=0;i<sizeof(h)-1;i+=n) {
+    n = min ((size_t)3, sizeof(h)-1-i);
+    this->header (h+i, n);
+  }
+  for (i=0;i<mlen;i+=n) {
+    n = min ((size_t)3, mlen-i);
+    this->encrypt (s+i, m+i, n);
+  }
+  this->trailer (t, sizeof(t)-1);
+  this->tag (s+mlen);
+  ok &= (memcmp (c, s, mlen+this->tag_size ())==0);
+
+  ok &= this->decrypt (bits, key, nonce, h, sizeof(h)-1, c, mlen+(bits>>1), t, sizeof(t)-1, s);
+  ok &= (memcmp (m, s, mlen)==0);
+
+  c[mlen] ^= 0x01;
+  ok &= !this->decrypt (bits, key, nonce, h, sizeof(h)-1, c, mlen+(bits>>1), t, sizeof(t)-1, s);
+  return _TEST (ok);
+}
+
+bool Norx::_test_aead (void) {
+  uint8_t bits, rate;
+  for (bits=32;bits<=NORX_MAX_BITS;bits+=32) {
+    rate = 10 * (bits>>3);
+    if (!this->_test_aead_one (bits, 0)) return 0;
+    if (!this->_test_aead_one (bits, rate-1)) return 0;
+    if (!this->_test_aead_one (bits, rate)) return 0;
+    if (!this->_test_aead_one (bits, rate+1)) return 0;
+  }
+  return 1;
+}
+
+/* keyed starts against plain ones, for a few nonces, rounds and D */
+bool Norx::_test_keyed (void) {
+  const uint8_t h[] = "keyed";
+  uint8_t key[32], nonce[16];
+  uint8_t m[AEAD_TEST_MAX];
+  uint8_t c[AEAD_TEST_MAX+NORX_MAX_TAG_SIZE];
+  uint8_t e[AEAD_TEST_MAX+NORX_MAX_TAG_SIZE];
+  uint8_t saved_r = this->rounds, saved_d = this->d;
+  uint8_t bits, i, j;
+  norx_key_t ctx;
+  bool ok;
+
+  for (i=0;i<32;i++) key[i] = 0x30 ^ i;
+  for (i=0;i<AEAD_TEST_MAX;i++) m[i] = i;
+  for (bits=32;bits<=NORX_MAX_BITS;bits+=32) {
+    for (i=0;i<3;i++) {
+      this->rounds = 4 + (i&1) * 2;
+      this->d = (i==2) ? 2 : 1;
+      Serial.print (F("* Testing keyed AEAD_"));
+      Serial.print (bits);
+      Serial.print (F(" R "));
+      Serial.print (this->rounds);
+      Serial.print (F(" D "));
+      Serial.println (this->d);
+      this->prepare (&ctx, bits, key);
+      ok = 1;
+      for (j=0;j<3;j++) {
+        memset (nonce, j, sizeof(nonce));
+        this->encrypt (bits, key, nonce, h, sizeof(h)-1, m, j*30, NULL, 0, c);
+        this->rounds = 6 - (i&1) * 2;
+        this->d = 1;
+        this->encrypt (&ctx, nonce, h, sizeof(h)-1, m, j*30, NULL, 0, e);
+        ok &= (memcmp (c, e, j*30+(bits>>1))==0);
+        ok &= this->decrypt (&ctx, nonce, h, sizeof(h)-1, e, j*30+(bits>>1), NULL, 0, c);
+        ok &= (memcmp (c, m, j*30)==0);
+      }
+      this->wipe (&ctx);
+      this->rounds = saved_r;
+      this->d = saved_d;
+      if (!_TEST (ok)) return 0;
+    }
+  }
+  // widths that are not built in are refused before anything is written
+  Serial.println (F("* Testing refusals"));
+  ok = !this->start (128, key, nonce);
+  ok &= !this->prepare (&ctx, 24, key);
+  ok &= !this->encrypt (24, key, nonce, h, sizeof(h)-1, m, 8, NULL, 0, c);
+  ok &= !this->decrypt (24, key, nonce, h, sizeof(h)-1, c, 20, NULL, 0, e);
+  // and so are R and D out of range, leaving both as they were
+  ok &= !this->begin (0, 1)&&!this->begin (64, 1)&&!this->begin (5, NORX_MAX_LANES + 1);
+  ok &= (this->rounds==saved_r)&&(this->d==saved_d);
+  return _TEST (ok);
+}
+
+#if NORX_SMALL
+/* Count 4 of host/kat/norx8.txt and norx16.txt, R 4 D 1. the inputs are
+   genkat.py's patterns, the lengths header, payload, trailer */
+const uint8_t _TEST_SMALL_LEN[2][3] PROGMEM = {{7, 5, 7}, {18, 16, 7}};
+const uint8_t _TEST_SMALL_CT_8[15] PROGMEM = {
+  0x4b, 0xa2, 0xf7, 0x6a, 0x11, 0x21, 0xec, 0x9b,
+  0x74, 0x60, 0xf6, 0x52, 0x30, 0x2c, 0xe7
+};
+const uint8_t _TEST_SMALL_CT_16[28] PROGMEM = {
+  0x06, 0xf9, 0x80, 0x6c, 0x8d, 0x52, 0xf0, 0xa3,
+  0x42, 0xfb, 0xc0, 0xb0, 0x1a, 0x75, 0x5e, 0xa4,
+  0x77, 0xa9, 0x7a, 0x38, 0x13, 0x2a, 0x07, 0x14,
+  0x2f, 0x73, 0xe3, 0x33
+};
+
+/* the stored u0 to u15 against F^2 of 0 to 15, then a known answer and its
+   round trip per width */
+bool Norx::_test_small (void) {
+  uint8_t key[12], nonce[4], h[18], m[16], t[7];
+  uint8_t c[16+12], e[16];
+  uint8_t saved_r = this->rounds, saved_d = this->d;
+  uint8_t bits, i, hl, ml, tl;
+  state_t s;
+  bool ok;
+
+  for (bits=8;bits<=16;bits+=8) {
+    Serial.print (F("* Testing NORX"));
+    Serial.println (bits);
+    s.bits = bits;
+    for (i=0;i<16;i++) this->_set_word (&s, i, i);
+    this->_permute (&s, 2);
+    ok = 1;
+    for (i=0;i<16;i++)
+      ok &= (this->_word (&s, i)==((bits==8) ? pgm_read_byte (&(NORX_INIT_8[i])) : pgm_read_word (&(NORX_INIT_16[i]))));
+
+    hl = pgm_read_byte (&(_TEST_SMALL_LEN[bits>>4][0]));
+    ml = pgm_read_byte (&(_TEST_SMALL_LEN[bits>>4][1]));
+    tl = pgm_read_byte (&(_TEST_SMALL_LEN[bits>>4][2]));
+    for (i=0;i<sizeof(key);i++) key[i] = i * 191 + 127;
+    for (i=0;i<sizeof(nonce);i++) nonce[i] = i * 181 + 127;
+    for (i=0;i<hl;i++) h[i] = i * 193 + 123;
+    for (i=0;i<ml;i++) m[i] = i * 197 + 123;
+    for (i=0;i<tl;i++) t[i] = i * 199 + 123;
+    this->rounds = 4;
+    this->d = 1;
+    this->encrypt (bits, key, nonce, h, hl, m, ml, t, tl, c);
+    // tag and verify leave no key dependent state behind
+    for (i=0;i<16;i++) ok &= (this->_word (&(this->state), i)==0);
+    for (i=0;i<ml+_tag_of (bits);i++)
+      ok &= (c[i]==pgm_read_byte ((bits==8) ? &(_TEST_SMALL_CT_8[i]) : &(_TEST_SMALL_CT_16[i])));
+    ok &= this->decrypt (bits, key, nonce, h, hl, c, ml+_tag_of (bits), t, tl, e);
+    for (i=0;i<16;i++) ok &= (this->_word (&(this->state), i)==0);
+    ok &= (memcmp (e, m, ml)==0);
+    c[ml] ^= 1;
+    ok &= !this->decrypt (bits, key, nonce, h, hl, c, ml+_tag_of (bits), t, tl, e);
+    this->rounds = saved_r;
+    this->d = saved_d;
+    if (!_TEST (ok)) return 0;
+  }
+  return 1;
+}
+#endif
+
+#if NORX_64
+/* the interleaved F^R (norx_bi64.h) against the plain one, whichever of
+   the two _permute uses */
+bool Norx::_test_bi64 (void) {
+  uint64_t a[16], b[16];
+  uint32_t e, o;
+  uint8_t i, r;
+  bool ok = 1;
+
+  Serial.println (F("* Testing bi64"));
+  for (i=0;i<16;i++) a[i] = ((uint64_t)0x9e3779b97f4a7c15ULL * (i + 1)) ^ ((uint64_t)1 << (i * 4 + 3));
+  for (i=0;i<16;i++) {
+    NorxBi64F::split (a[i], e, o);
+    ok &= (NorxBi64F::join (e, o)==a[i]);
+  }
+  for (r=1;r<=6;r++) {
+    memcpy (b, a, sizeof(a));
+    NorxBi64F::permute (a, r);
+    for (i=0;i<r;i++) Norx64F::permute (b);
+    ok &= (memcmp (a, b, sizeof(a))==0);
+  }
+  memcpy (b, a, sizeof(a));
+  NorxBi64<4>::permute (a);
+  NorxCore<uint64_t, 4>::permute (b);
+  ok &= (memcmp (a, b, sizeof(a))==0);
+  return _TEST (ok);
+}
+#endif
+
+/* in place and unaligned buffers, and segments, against the plain one shot
+   path */
+bool Norx::_test_inplace (void) {
+  uint8_t h[] = "in place header";
+  uint8_t key[32], nonce[16];
+  uint8_t m[AEAD_TEST_MAX];
+  uint8_t c[AEAD_TEST_MAX+NORX_MAX_TAG_SIZE];
+  uint8_t b[AEAD_TEST_MAX+NORX_MAX_TAG_SIZE+1];
+  uint8_t tag[NORX_MAX_TAG_SIZE];
+  norx_seg_t hs[2], ms[3];
+  norx_key_t ctx;
+  uint8_t bits, len, i;
+  bool ok;
+
+  for (i=0;i<32;i++) key[i] = 0xc0 + i;
+  memset (nonce, 0x11, sizeof(nonce));
+  for (i=0;i<AEAD_TEST_MAX;i++) m[i] = 0xff - i;
+  for (bits=32;bits<=NORX_MAX_BITS;bits+=32) {
+    Serial.print (F("* Testing in place AEAD_"));
+    Serial.println (bits);
+    len = 10 * (bits>>3) + 1;
+    this->encrypt (bits, key, nonce, h, sizeof(h)-1, m, len, NULL, 0, c);
+
+    // same buffer, odd address
+    memcpy (b+1, m, len);
+    this->encrypt (bits, key, nonce, h, sizeof(h)-1, b+1, len, NULL, 0, b+1);
+    ok = (memcmp (b+1, c, len+(bits>>1))==0);
+    ok &= this->decrypt (bits, key, nonce, h, sizeof(h)-1, b+1, len+(bits>>1), NULL, 0, b+1);
+    ok &= (memcmp (b+1, m, len)==0);
+
+    // segments, split across block boundaries
+    hs[0].p = h;      hs[0].len = 4;
+    hs[1].p = h + 4;  hs[1].len = sizeof(h)-1-4;
+    ms[0].p = b;      ms[0].len = 1;
+    ms[1].p = b + 1;  ms[1].len = len - 4;
+    ms[2].p = b + len - 3; ms[2].len = 3;
+    memcpy (b, m, len);
+    this->prepare (&ctx, bits, key);
+    this->encrypt (&ctx, nonce, hs, 2, ms, 3, NULL, 0, tag);
+    ok &= (memcmp (b, c, len)==0);
+    ok &= (memcmp (tag, c+len, bits>>1)==0);
+    ok &= this->decrypt (&ctx, nonce, hs, 2, ms, 3, NULL, 0, tag);
+    ok &= (memcmp (b, m, len)==0);
+    tag[0] ^= 0x01;
+    memcpy (b, c, len);
+    ok &= !this->decrypt (&ctx, nonce, hs, 2, ms, 3, NULL, 0, tag);
+    for (i=0;i<len;i++) ok &= (b[i]==0);
+    this->wipe (&ctx);
+    if (!_TEST (ok)) return 0;
+  }
+  return 1;
+}
+
+/* a stream saved and restored halfway through each phase, and damaged
+   blobs */
+bool Norx::_test_save (void) {
+  const uint8_t h[] = "saved header";
+  uint8_t key[32], nonce[16];
+  uint8_t m[AEAD_TEST_MAX];
+  uint8_t c[AEAD_TEST_MAX+NORX_MAX_TAG_SIZE];
+  uint8_t e[AEAD_TEST_MAX+NORX_MAX_TAG_SIZE];
+  static uint8_t blob[NORX_SAVE_MAX];
+  const uint8_t ds[] = { 1, 2, 0 };
+  uint8_t saved = this->d;
+  uint8_t bits, i, j;
+  size_t len;
+  bool ok;
+
+  for (i=0;i<32;i++) key[i] = i * 5;
+  memset (nonce, 0x42, sizeof(nonce));
+  for (i=0;i<AEAD_TEST_MAX;i++) m[i] = i ^ 0x5a;
+  // NORX8 and NORX16 too, their D is kept but they have no lanes
+  for (bits=NORX_MIN_BITS;bits<=NORX_MAX_BITS;bits<<=1) {
+    for (i=0;i<sizeof(ds);i++) {
+      Serial.print (F("* Testing save/restore AEAD_"));
+      Serial.print (bits);
+      Serial.print (F(" D "));
+      Serial.println (ds[i]);
+      this->d = ds[i];
+      this->encrypt (bits, key, nonce, h, sizeof(h)-1, m, AEAD_TEST_MAX, h, 3, c);
+
+      this->start (bits, key, nonce);
+      this->header (h, 5);
+      len = this->save (blob);
+      this->start (bits, m, m);
+      ok = (this->restore (blob, len)==NORX_RESTORE_OK);
+      this->header (h+5, sizeof(h)-1-5);
+      this->encrypt (e, m, 45);
+      len = this->save (blob);
+      this->d = 1;
+      ok &= (this->restore (blob, len)==NORX_RESTORE_OK);
+      this->encrypt (e+45, m+45, AEAD_TEST_MAX-45);
+      this->trailer (h, 3);
+      len = this->save (blob);
+      ok &= (this->restore (blob, len)==NORX_RESTORE_OK);
+      this->tag (e+AEAD_TEST_MAX);
+      ok &= (memcmp (c, e, AEAD_TEST_MAX+_tag_of (bits))==0);
+
+      // damaged blobs leave the instance alone
+      ok &= (this->restore (blob, len-1)==NORX_RESTORE_LENGTH);
+      blob[0] ^= 0xff;
+      ok &= (this->restore (blob, len)==NORX_RESTORE_MAGIC);
+      blob[0] ^= 0xff;
+      blob[1]++;
+      ok &= (this->restore (blob, len)==NORX_RESTORE_VERSION);
+      blob[1]--;
+      for (j=13;j<len;j+=17) {
+        blob[j] ^= 0x10;
+        ok &= (this->restore (blob, len)==NORX_RESTORE_CRC);
+        blob[j] ^= 0x10;
+      }
+      this->d = saved;
+      if (!_TEST (ok)) return 0;
+    }
+  }
+  return 1;
+}
+
+#define PARALLEL_TEST_LEN (2*NORX_THREADS_MIN+77)
+
+/* the lanes must change the tag, and the pool must match the lanes run
+ * one block at a time */
+bool Norx::_test_parallel (void) {
+#if NORX_MAX_LANES>=4
+  const uint8_t ds[] = { 2, 3, 0 };
+#else
+  const uint8_t ds[] = { 2, 0 };
+#endif
+  uint8_t key[32], nonce[16];
+  uint8_t c[AEAD_TEST_MAX+NORX_MAX_TAG_SIZE];
+  uint8_t e[AEAD_TEST_MAX+NORX_MAX_TAG_SIZE];
+  uint8_t saved = this->d;
+  uint8_t bits, rate, i;
+  bool ok = 1;
+
+  memset (key, 0x5a, sizeof(key));
+  memset (nonce, 0xa5, sizeof(nonce));
+  for (bits=32;bits<=NORX_MAX_BITS;bits+=32) {
+    rate = 10 * (bits>>3);
+    for (i=0;i<sizeof(ds);i++) {
+      this->d = ds[i];
+      ok &= this->_test_aead_one (bits, 0);
+      ok &= this->_test_aead_one (bits, rate-1);
+      ok &= this->_test_aead_one (bits, rate+1);
+      if (2*rate<AEAD_TEST_MAX) ok &= this->_test_aead_one (bits, 2*rate+1);
+
+      Serial.print (F("* Testing AEAD_"));
+      Serial.print (bits);
+      Serial.print (F(" D "));
+      Serial.print (this->d);
+      Serial.println (F(" vs D 1"));
+      memset (c, 0, sizeof(c));
+      this->encrypt (bits, key, nonce, NULL, 0, c, AEAD_TEST_MAX, NULL, 0, e);
+      this->d = 1;
+      this->encrypt (bits, key, nonce, NULL, 0, c, AEAD_TEST_MAX, NULL, 0, c);
+      ok &= _TEST (memcmp (c, e, AEAD_TEST_MAX+(bits>>1))!=0);
+    }
+  }
+#if NORX_THREADS
+  static uint8_t m[PARALLEL_TEST_LEN];
+  static uint8_t x[PARALLEL_TEST_LEN+NORX_MAX_TAG_SIZE];
+  static uint8_t y[PARALLEL_TEST_LEN+NORX_MAX_TAG_SIZE];
+  size_t j, n;
+
+  for (j=0;j<PARALLEL_TEST_LEN;j++) m[j] = j * 13;
+  for (bits=32;bits<=NORX_MAX_BITS;bits+=32) {
+    for (i=0;i<sizeof(ds);i++) {
+      this->d = ds[i];
+      Serial.print (F("* Testing pool AEAD_"));
+      Serial.print (bits);
+      Serial.print (F(" D "));
+      Serial.println (this->d);
+      this->encrypt (bits, key, nonce, NULL, 0, m, PARALLEL_TEST_LEN, NULL, 0, x);
+      this->start (bits, key, nonce);
+      for (j=0;j<PARALLEL_TEST_LEN;j+=n) {
+        n = min ((size_t)1000, PARALLEL_TEST_LEN-j);
+        this->encrypt (y+j, m+j, n);
+      }
+      this->tag (y+PARALLEL_TEST_LEN);
+      bool r = (memcmp (x, y, PARALLEL_TEST_LEN+(bits>>1))==0);
+      r &= this->decrypt (bits, key, nonce, NULL, 0, x, PARALLEL_TEST_LEN+(bits>>1), NULL, 0, y);
+      r &= (memcmp (m, y, PARALLEL_TEST_LEN)==0);
+      ok &= _TEST (r);
+    }
+  }
+#endif
+  this->d = saved;
+  return ok;
+}
+
+#if NORX_STATS
+/* one NORX32 R4 D1 message : 1 header, 3 payload and 1 trailer block */
+bool Norx::_test_stats (void) {
+  const norx_stats_t* st = &(this->stat);
+  uint8_t key[16], nonce[8];
+  uint8_t m[AEAD_TEST_MAX];
+  uint8_t c[AEAD_TEST_MAX+NORX_MAX_TAG_SIZE];
+  uint8_t saved = this->d, rounds = this->rounds;
+  bool ok = 1;
+  uint8_t i;
+
+  Serial.println (F("* Testing stats"));
+  memset (key, 0x11, sizeof(key));
+  memset (nonce, 0x22, sizeof(nonce));
+  memset (m, 0x33, sizeof(m));
+  this->d = 1;
+  this->rounds = 4;
+  this->stats_reset ();
+  this->encrypt (32, key, nonce, m, 10, m, AEAD_TEST_MAX, m, 5, c);
+  // the three data phases are probed once per call and once when closed
+  ok &= (st->s[NORX_STAT_INIT].calls==1) && (st->s[NORX_STAT_FINAL].calls==1);
+  for (i=NORX_STAT_HEADER;i<=NORX_STAT_TRAILER;i++) ok &= (st->s[i].calls==2);
+  ok &= (st->s[NORX_STAT_F].calls==8) && (st->rounds==32);
+  ok &= (st->s[NORX_STAT_F].cycles>0) && (st->s[NORX_STAT_F].max<=st->s[NORX_STAT_F].cycles);
+  for (i=0;i<NORX_STAT_COUNT;i++) ok &= (st->s[i].stack>0);
+  // init and final enclose F^R, they go at least as deep (as deep when
+  // _permute is inlined into them)
+  ok &= (st->s[NORX_STAT_INIT].stack>=st->s[NORX_STAT_F].stack);
+  ok &= (st->s[NORX_STAT_FINAL].stack>=st->s[NORX_STAT_F].stack);
+  this->stats_reset ();
+  this->d = saved;
+  this->rounds = rounds;
+  return _TEST (ok);
+}
+#endif
+#endif
@@ -8,26 +8,194 @@ typedef union {
   uint32_t b32;
 } stw;
 
+// NORX_64=0 leaves NORX64 out, every state is then 64 bytes smaller
+#ifndef NORX_64
+#define NORX_64 1
+#endif
+
+#if NORX_64
+#define NORX_MAX_BITS 64
+#else
+#define NORX_MAX_BITS 32
+#endif
+
+// NORX_DIAG=1 builds the verbose self test, Norx::test, and its vector
+// tables. the host build has it, a board only needs Norx::post
+#ifndef NORX_DIAG
+#if defined(ARDUINO_HOST)
+#define NORX_DIAG 1
+#else
+#define NORX_DIAG 0
+#endif
+#endif
+
+// NORX8 and NORX16, sequential only, keys and tags in norx.cpp (init).
+// NORX_SMALL=0 leaves them out
+#ifndef NORX_SMALL
+#define NORX_SMALL 1
+#endif
+
+#if NORX_SMALL
+#define NORX_MIN_BITS 8
+#else
+#define NORX_MIN_BITS 32
+#endif
+
+// the sixteen state words at their actual width
+typedef struct {
+  uint32_t w[16];
+} state32_t;
+
+typedef struct {
+  uint64_t w[16];
+} state64_t;
+
+typedef struct {
+  uint8_t w[16];
+} state8_t;
+
+typedef struct {
+  uint16_t w[16];
+} state16_t;
+
+// bits (8, 16, 32 or 64) selects the member
 typedef struct {
   uint8_t bits;
   uint8_t rounds;
-  stw     state[16];
+  union {
+#if NORX_SMALL
+    state8_t s8;
+    state16_t s16;
+#endif
+    state32_t s32;
+#if NORX_64
+    state64_t s64;
+#endif
+  };
 } state_t;
 
+#include "norx_trace.h"
+#include "norx_stats.h"
+
+// domain separation constants, injected in word 15
+#define NORX_TAG_HEADER   0x01
+#define NORX_TAG_PAYLOAD  0x02
+#define NORX_TAG_TRAILER  0x04
+#define NORX_TAG_FINAL    0x08
+#define NORX_TAG_BRANCH   0x10
+#define NORX_TAG_MERGE    0x20
+
+#define NORX_MODE_ABSORB  0
+#define NORX_MODE_ENCRYPT 1
+#define NORX_MODE_DECRYPT 2
+
+#define NORX_MAX_TAG_SIZE 32
+
+// payload lane states, D>1 needs D of them and D=0 needs two
+#ifndef NORX_MAX_LANES
+#if defined(ARDUINO_HOST)
+#define NORX_MAX_LANES 16
+#else
+#define NORX_MAX_LANES 2
+#endif
+#endif
+
+/***************************************************************************
+ * RAM budget on AVR (no padding, 2 byte pointers and size_t), default
+ * build / NORX_64=0, with NORX_MAX_LANES=2 :
+ *
+ *   state_t         130 / 66
+ *   norx_key_t      131 / 67
+ *   Norx            402 / 210   state, two lanes and the stream position
+ *
+ * worst case stack of the locals per operation, NORX64 / NORX32 ; add the
+ * saved registers and return address of each frame, a few bytes apiece.
+ * these come from the declarations ; norxtest measures the real peaks with
+ * norx_stack.h and prints them at start
+ *
+ *   F^R             128 / 64    NorxCore::permute works on a copy
+ *   start           176 / 112   key and nonce words (48) then F^R
+ *   keyed start     136 / 72    one nonce word then F^R
+ *   prepare          80 / 80    key and nonce words, _setup
+ *   header, encrypt, decrypt, trailer   F^R when a block is opened
+ *   tag             128 / 64    F^R
+ *   verify, one shot decrypt    160 / 96    tag copy (32) and F^R
+ *   post ()         330 / 210   a block and its tag (112), key and nonce
+ *                               (48), then one shot decrypt
+ *   test ()         about 800   _test_parallel (274 bytes of buffers)
+ *                               calls _test_aead_one (355) which calls
+ *                               one shot decrypt. the F vectors are read
+ *                               from flash a word at a time, into the lanes
+ */
+
+// saved streaming contexts, see Norx::save. the blob is a 13 byte header,
+// the state then the lanes in use (16 little endian words each), and a
+// CRC-32 of all that
+#define NORX_SAVE_MAGIC      0x4e
+#define NORX_SAVE_VERSION    1
+#define NORX_SAVE_SIZE(bits, lanes) ((size_t)(13 + (1 + (lanes)) * 2 * (bits) + 4))
+#define NORX_SAVE_MAX        NORX_SAVE_SIZE (NORX_MAX_BITS, NORX_MAX_LANES)
+
+#define NORX_RESTORE_OK      0
+#define NORX_RESTORE_LENGTH  1
+#define NORX_RESTORE_MAGIC   2
+#define NORX_RESTORE_VERSION 3
+#define NORX_RESTORE_CRC     4
+#define NORX_RESTORE_PARAMS  5
+
+// a buffer segment, for the scatter/gather calls
+typedef struct {
+  uint8_t* p;
+  size_t   len;
+} norx_seg_t;
+
+// nonce independent start of the state under one key, see Norx::prepare
+typedef struct {
+  state_t tmpl;
+  uint8_t d;
+} norx_key_t;
+
 class Norx {
+  friend class NorxBench;
+  friend class NorxBatch;
+  friend class NorxCt;
+  friend class NorxDrbg;
+  friend class NorxKat;
+  friend class NorxFuzz;
+  friend class NorxProto;
+  friend class NorxStep;
+
   private :
   uint8_t rounds;
   state_t state;
+  uint8_t phase;
+  uint8_t pos;
+  uint8_t used;
+  uint8_t d;
+  uint8_t open;
+  size_t blk;
+  state_t* cur;
+  state_t lane[NORX_MAX_LANES];
+  norx_trace_sink_t sink;
+#if NORX_STATS
+  norx_stats_t stat;
+#endif
 
   // helper functions
   void dump_state_word (uint8_t bits, stw* w);
   void empty_state (uint8_t bits, state_t* s);
   void dump_state (state_t* s, char* prefix);
+  void dump_prgm_state (uint8_t bits, const void* p, char* prefix);
+  void _dump (uint8_t bits, state_t* s, const void* p, char* prefix);
   void load_state_word_from_hex (uint8_t bits, stw* w, char* hex_str);
   void copy_state_word (uint8_t bits, stw* s, stw* d);
   void copy_state (state_t* s, state_t* d);
   bool compare_state_word (uint8_t bits, stw* wa, stw* wb);
   bool compare_state (state_t* sa, state_t* sb);
+  void _trace (state_t* s, char* label);
+  uint64_t _word (state_t* s, uint8_t i);
+  void _set_word (state_t* s, uint8_t i, uint64_t v);
+  void _xor_word (state_t* s, uint8_t i, uint64_t v);
 
   // crypto functions
   void _XOR_32(stw* w, stw* a, stw* b);
@@ -44,11 +212,56 @@ class Norx {
   void _XRL_64(stw* w, stw* a, stw* b, uint8_t v);
   void __G_32 (stw* wa, stw* wb, stw* wc, stw* wd);
   void __G_64 (stw* wa, stw* wb, stw* wc, stw* wd);
+  void _G_ref (state_t* s, uint8_t a, uint8_t b, uint8_t c, uint8_t d);
+  void _F_ref (state_t* s);
   void _G (state_t* s, uint8_t a, uint8_t b, uint8_t c, uint8_t d);
   void _F (state_t* s);
+  void _permute (state_t* s, uint8_t r);
+
+  void _setup (state_t* s, uint8_t w, uint8_t r, uint8_t d, uint16_t a, stw k[4], stw n[2]);
+  void _init (state_t* s, uint8_t w, uint8_t r, uint8_t d, uint16_t a, stw k[4], stw n[2], uint16_t hlen);
+  void _init_F (state_t* s, uint8_t r);
+  void _setup_small (state_t* s, uint8_t w, uint8_t r, const uint8_t* key, const uint8_t* nonce);
+  bool _load (state_t* s, uint8_t bits, const uint8_t* key, const uint8_t* nonce);
+  void _nonce (state_t* s, const uint8_t* nonce);
+
+  // AEAD functions
+  uint8_t _rate (state_t* s);
+  uint8_t* _rate_byte (state_t* s, uint8_t i);
+  void _load_word (uint8_t bits, stw* w, const uint8_t* p);
+  void _inject (state_t* s, uint8_t v);
+  bool _parallel (void);
+  void _next_block (void);
+  void _duplex (uint8_t* out, const uint8_t* in, size_t len, uint8_t mode);
+  void _rate_block (state_t* s, uint8_t* out, const uint8_t* in, uint8_t mode);
+  void _end_phase (void);
+  void _pad (void);
+  bool _phase (uint8_t p);
+  void _start (void);
+  void _encrypt (const uint8_t* h, size_t hlen, const uint8_t* m, size_t mlen,
+                 const uint8_t* t, size_t tlen, uint8_t* c);
+  bool _decrypt (const uint8_t* h, size_t hlen, const uint8_t* c, size_t clen,
+                 const uint8_t* t, size_t tlen, uint8_t* m);
 
-  void _init (state_t* s, uint8_t w, uint8_t r, uint8_t d, uint8_t a, stw k[4], stw n[2], uint16_t hlen);
+  // parallel payload
+  void _lane_id (state_t* s, size_t id);
+  void _branch (void);
+  void _fork (void);
+  void _next_lane (void);
+  void _merge (state_t* l, state_t* s);
+  void _fold (state_t* l, state_t* s);
+  void _merge_lanes (void);
+  void _block (state_t* s, uint8_t* out, const uint8_t* in, uint8_t mode);
+  void _bulk (uint8_t* out, const uint8_t* in, size_t n, uint8_t mode);
+  static void _bulk_lane (void* arg, uint8_t i);
+  static void _bulk_blocks (void* arg, uint8_t i);
   
+  // flash copies, for the F vectors and the dumps
+  void prgm_copy_state_word (uint8_t bits, void* s, stw* d);
+  void _prgm_word (uint8_t bits, const void* p, uint8_t i, stw* w);
+  void prgm_copy_state (uint8_t bits, const void* p, state_t* d);
+
+#if NORX_DIAG
   // test functions
   bool _test_32 (void);
   bool _test_64 (void);
@@ -61,19 +274,101 @@ class Norx {
   bool _test_ROR (uint8_t bits);
   bool _test_ADX (uint8_t bits);
   bool _test_XRL (uint8_t bits);
-  void prgm_copy_state_word (uint8_t bits, void* s, stw* d);
   bool _test_G_one (uint8_t bits, uint8_t idx);
   bool _test_G (uint8_t bits);
-  void prgm_copy_state (state_t* s, state_t* d);
-  bool _test_F_one (uint8_t i, state_t* s);
+  const void* _prgm_vector (uint8_t bits, uint8_t i);
+  bool _test_vector (uint8_t bits, uint8_t i, state_t* s);
+  bool _test_F_one (uint8_t bits, uint8_t i, state_t* s, state_t* r);
   bool _test_F ();
   bool _test_init (void);
-  //
+  bool _test_aead_one (uint8_t bits, size_t mlen);
+  bool _test_aead (void);
+  bool _test_parallel (void);
+  bool _test_keyed (void);
+  bool _test_inplace (void);
+  bool _test_save (void);
+  bool _test_stats (void);
+  bool _test_small (void);
+  bool _test_bi64 (void);
+#endif
   
   public :
     Norx (void);
-    void begin (uint8_t rounds);
+    // d is the parallelism, 1 sequential, 2..NORX_MAX_LANES lanes, or 0
+    // for one lane per payload block. rounds is 1 to 63. returns 0 and
+    // changes nothing if either is not supported
+    bool begin (uint8_t rounds, uint8_t d = 1);
+    // power-on self test, quiet and bounded (see norx.cpp)
+    bool post (void);
+#if NORX_DIAG
+    // every test vector, printed as it goes
     bool test (void);
+#endif
+    void trace (norx_trace_sink_t sink);
+#if NORX_STATS
+    // cycles and stack per phase and per F^R, see norx_stats.h
+    const norx_stats_t* stats (void);
+    void stats_reset (void);
+#endif
+
+    // streaming AEAD, start then header, encrypt or decrypt, trailer,
+    // and finally tag or verify. any of the three data phases may be
+    // skipped and each may be fed in chunks of any size. the key is 4
+    // words and the nonce 2, but 10 and 4 bytes on NORX8, 12 and 4 on NORX16.
+    // start returns 0 and changes nothing if bits is not built in
+    bool start (uint8_t bits, const uint8_t* key, const uint8_t* nonce);
+    bool header (const uint8_t* h, size_t len);
+    bool encrypt (uint8_t* c, const uint8_t* m, size_t len);
+    bool decrypt (uint8_t* m, const uint8_t* c, size_t len);
+    bool trailer (const uint8_t* t, size_t len);
+    void tag (uint8_t* t);
+    bool verify (const uint8_t* t);
+    uint8_t tag_size (void);
+
+    // the same over n segments. the payload is encrypted or decrypted in
+    // place, header and trailer segments are only read
+    bool header (const norx_seg_t* h, uint8_t n);
+    bool encrypt (norx_seg_t* m, uint8_t n);
+    bool decrypt (norx_seg_t* c, uint8_t n);
+    bool trailer (const norx_seg_t* t, uint8_t n);
+
+    // saved contexts, to carry a stream across a power loss. save writes
+    // at most NORX_SAVE_MAX bytes and returns the length, restore returns
+    // one of NORX_RESTORE_*. the blob is the live state, as secret as the
+    // key, and the CRC only catches corruption, not tampering
+    size_t save (uint8_t* blob);
+    uint8_t restore (const uint8_t* blob, size_t len);
+
+    // keyed contexts, for many messages under one key. prepare takes the
+    // rounds and D of the instance, a keyed start switches back to them.
+    // prepare returns 0 if bits is not built in
+    bool prepare (norx_key_t* ctx, uint8_t bits, const uint8_t* key);
+    void wipe (norx_key_t* ctx);
+    void start (const norx_key_t* ctx, const uint8_t* nonce);
+
+    // one shot AEAD. c and m may be the same buffer, both return 0 if
+    // bits is not built in
+    bool encrypt (uint8_t bits, const uint8_t* key, const uint8_t* nonce,
+                  const uint8_t* h, size_t hlen, const uint8_t* m, size_t mlen,
+                  const uint8_t* t, size_t tlen, uint8_t* c);
+    bool decrypt (uint8_t bits, const uint8_t* key, const uint8_t* nonce,
+                  const uint8_t* h, size_t hlen, const uint8_t* c, size_t clen,
+                  const uint8_t* t, size_t tlen, uint8_t* m);
+    void encrypt (const norx_key_t* ctx, const uint8_t* nonce,
+                  const uint8_t* h, size_t hlen, const uint8_t* m, size_t mlen,
+                  const uint8_t* t, size_t tlen, uint8_t* c);
+    bool decrypt (const norx_key_t* ctx, const uint8_t* nonce,
+                  const uint8_t* h, size_t hlen, const uint8_t* c, size_t clen,
+                  const uint8_t* t, size_t tlen, uint8_t* m);
+
+    // one shot in place over segments, with a separate tag. the payload
+    // segments are zeroed if the tag does not match
+    void encrypt (const norx_key_t* ctx, const uint8_t* nonce,
+                  const norx_seg_t* h, uint8_t hn, norx_seg_t* m, uint8_t mn,
+                  const norx_seg_t* t, uint8_t tn, uint8_t* tag);
+    bool decrypt (const norx_key_t* ctx, const uint8_t* nonce,
+                  const norx_seg_t* h, uint8_t hn, norx_seg_t* c, uint8_t cn,
+                  const norx_seg_t* t, uint8_t tn, const uint8_t* tag);
 };
 
 #endif
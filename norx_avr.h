@@ -0,0 +1,105 @@
+#ifndef __norx_avr_h_
+#define __norx_avr_h_
+
+/***************************************************************************
+ * AVR assembly G for NORX32, included by norx_core.h
+ *
+ * the four words and a temporary stay in registers for the whole of G :
+ *   ROR 8 and ROR 16 are byte moves, ROR 11 is ROR 8 then three single bit
+ *   rotations, ROR 31 is a single bit left rotation
+ * about 125 cycles per G, against a few hundred for the generic C++ that
+ * avr-gcc turns into shift loops. set NORX_AVR_ASM to 0 to use the C++.
+ *
+ * operands : %0 a, %1 b, %2 c, %3 d, %4 temporary
+ * bytes    : %A least significant to %D most significant
+ */
+
+#if defined(__AVR__)
+#ifndef NORX_AVR_ASM
+#define NORX_AVR_ASM 1
+#endif
+#else
+#undef NORX_AVR_ASM
+#define NORX_AVR_ASM 0
+#endif
+
+// x = (x ^ y) ^ ((x & y) << 1)
+#define NORX_AVR_H(x, y) \
+  "movw %A4, %A" #x "\n\t" \
+  "movw %C4, %C" #x "\n\t" \
+  "and  %A4, %A" #y "\n\t" \
+  "and  %B4, %B" #y "\n\t" \
+  "and  %C4, %C" #y "\n\t" \
+  "and  %D4, %D" #y "\n\t" \
+  "eor  %A" #x ", %A" #y "\n\t" \
+  "eor  %B" #x ", %B" #y "\n\t" \
+  "eor  %C" #x ", %C" #y "\n\t" \
+  "eor  %D" #x ", %D" #y "\n\t" \
+  "lsl  %A4\n\t" \
+  "rol  %B4\n\t" \
+  "rol  %C4\n\t" \
+  "rol  %D4\n\t" \
+  "eor  %A" #x ", %A4\n\t" \
+  "eor  %B" #x ", %B4\n\t" \
+  "eor  %C" #x ", %C4\n\t" \
+  "eor  %D" #x ", %D4\n\t"
+
+// x ^= y
+#define NORX_AVR_XOR(x, y) \
+  "eor  %A" #x ", %A" #y "\n\t" \
+  "eor  %B" #x ", %B" #y "\n\t" \
+  "eor  %C" #x ", %C" #y "\n\t" \
+  "eor  %D" #x ", %D" #y "\n\t"
+
+#define NORX_AVR_ROR8(x) \
+  "mov  __tmp_reg__, %A" #x "\n\t" \
+  "mov  %A" #x ", %B" #x "\n\t" \
+  "mov  %B" #x ", %C" #x "\n\t" \
+  "mov  %C" #x ", %D" #x "\n\t" \
+  "mov  %D" #x ", __tmp_reg__\n\t"
+
+#define NORX_AVR_ROR1(x) \
+  "bst  %A" #x ", 0\n\t" \
+  "lsr  %D" #x "\n\t" \
+  "ror  %C" #x "\n\t" \
+  "ror  %B" #x "\n\t" \
+  "ror  %A" #x "\n\t" \
+  "bld  %D" #x ", 7\n\t"
+
+#define NORX_AVR_ROL1(x) \
+  "lsl  %A" #x "\n\t" \
+  "rol  %B" #x "\n\t" \
+  "rol  %C" #x "\n\t" \
+  "rol  %D" #x "\n\t" \
+  "adc  %A" #x ", __zero_reg__\n\t"
+
+#define NORX_AVR_ROR16(x) \
+  "movw %A4, %A" #x "\n\t" \
+  "movw %A" #x ", %C" #x "\n\t" \
+  "movw %C" #x ", %A4\n\t"
+
+#define NORX_AVR_G32_ASM \
+  NORX_AVR_H(0, 1) \
+  NORX_AVR_XOR(3, 0) NORX_AVR_ROR8(3) \
+  NORX_AVR_H(2, 3) \
+  NORX_AVR_XOR(1, 2) NORX_AVR_ROR8(1) NORX_AVR_ROR1(1) NORX_AVR_ROR1(1) NORX_AVR_ROR1(1) \
+  NORX_AVR_H(0, 1) \
+  NORX_AVR_XOR(3, 0) NORX_AVR_ROR16(3) \
+  NORX_AVR_H(2, 3) \
+  NORX_AVR_XOR(1, 2) NORX_AVR_ROL1(1)
+
+#if NORX_AVR_ASM
+
+template <> struct NorxG<uint32_t> {
+  static inline void G (uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
+    uint32_t t;
+    asm volatile (
+      NORX_AVR_G32_ASM
+      : "+r" (a), "+r" (b), "+r" (c), "+r" (d), "=&r" (t)
+    );
+  }
+};
+
+#endif
+
+#endif
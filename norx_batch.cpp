@@ -0,0 +1,337 @@
+#include <string.h>
+#include "norx_batch.h"
+
+#if NORX_BATCH
+
+#include "norx_core.h"
+#include "cryptoutils.h"
+#include "norx_ct.h"
+
+// the vector helpers below are always inlined, no vector crosses a call
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+#define LANE_IDLE    0
+#define LANE_INIT    1
+#define LANE_HEADER  2
+#define LANE_PAYLOAD 3
+#define LANE_TRAILER 4
+#define LANE_FINAL1  5
+#define LANE_FINAL2  6
+
+typedef struct {
+  norx_job_t* job;
+  uint8_t     stage;
+  size_t      off;
+} lane_t;
+
+/***************************************************************************
+ * transposed permutation, s[i][l] is word i of lane l
+ */
+
+template <typename W, uint8_t L>
+struct NorxLanes {
+  typedef W vec __attribute__ ((vector_size (sizeof(W) * L)));
+  typedef NorxWord<W> word;
+
+  static inline __attribute__ ((always_inline)) vec H (vec a, vec b) {
+    return (a ^ b) ^ ((a & b) << 1);
+  }
+
+  static inline __attribute__ ((always_inline)) vec ROR (vec x, uint8_t n) {
+    return (x >> n) | (x << (word::bits - n));
+  }
+
+  static inline __attribute__ ((always_inline)) void G (vec& a, vec& b, vec& c, vec& d) {
+    a = H (a, b); d = ROR (a ^ d, word::r0);
+    c = H (c, d); b = ROR (b ^ c, word::r1);
+    a = H (a, b); d = ROR (a ^ d, word::r2);
+    c = H (c, d); b = ROR (b ^ c, word::r3);
+  }
+
+  static inline __attribute__ ((always_inline)) void permute (W s[16][L], uint8_t r) {
+    vec x[16];
+    uint8_t i;
+    for (i=0;i<16;i++) memcpy (&(x[i]), s[i], sizeof(vec));
+    while (r--) {
+      G (x[0], x[4], x[ 8], x[12]);
+      G (x[1], x[5], x[ 9], x[13]);
+      G (x[2], x[6], x[10], x[14]);
+      G (x[3], x[7], x[11], x[15]);
+      G (x[0], x[5], x[10], x[15]);
+      G (x[1], x[6], x[11], x[12]);
+      G (x[2], x[7], x[ 8], x[13]);
+      G (x[3], x[4], x[ 9], x[14]);
+    }
+    for (i=0;i<16;i++) memcpy (s[i], &(x[i]), sizeof(vec));
+  }
+};
+
+template <typename W, uint8_t L>
+static void _permute_lanes (W s[16][L], uint8_t r) {
+  NorxLanes<W, L>::permute (s, r);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+template <typename W, uint8_t L>
+__attribute__ ((target ("avx2")))
+static void _permute_lanes_avx2 (W s[16][L], uint8_t r) {
+  NorxLanes<W, L>::permute (s, r);
+}
+#endif
+
+/***************************************************************************
+ * lane helpers
+ */
+
+template <typename W>
+static inline W _load_le (const uint8_t* p) {
+  W v = 0;
+  for (uint8_t i=sizeof(W);i>0;i--) v = (v << 8) | p[i-1];
+  return v;
+}
+
+template <typename W>
+static inline void _store_le (uint8_t* p, W v) {
+  for (uint8_t i=0;i<sizeof(W);i++) { p[i] = (uint8_t)v; v >>= 8; }
+}
+
+static inline uint32_t _word (state_t* s, uint8_t i, uint32_t*) { return s->s32.w[i]; }
+#if NORX_64
+static inline uint64_t _word (state_t* s, uint8_t i, uint64_t*) { return s->s64.w[i]; }
+#endif
+
+/* first stage with data after stage, or the finalization */
+static uint8_t _next_stage (norx_job_t* j, uint8_t stage) {
+  if ((stage<LANE_HEADER)&&(j->hlen)) return LANE_HEADER;
+  if ((stage<LANE_PAYLOAD)&&(j->len)) return LANE_PAYLOAD;
+  if ((stage<LANE_TRAILER)&&(j->tlen)) return LANE_TRAILER;
+  return LANE_FINAL1;
+}
+
+/* one block of n bytes into lane l, n<rate is the padded last block */
+template <typename W, uint8_t L>
+static void _block (W s[16][L], uint8_t l, const uint8_t* in, uint8_t* out, size_t n, uint8_t mode) {
+  const uint8_t rate = 10 * sizeof(W);
+  uint8_t b[10 * sizeof(W)];
+  uint8_t i, v;
+  W c;
+
+  if (n==rate) {
+    for (i=0;i<10;i++) {
+      c = _load_le<W> (in + i*sizeof(W));
+      if (mode==NORX_MODE_DECRYPT) {
+        _store_le<W> (out + i*sizeof(W), s[i][l] ^ c);
+        s[i][l] = c;
+      } else {
+        s[i][l] ^= c;
+        if (mode==NORX_MODE_ENCRYPT) _store_le<W> (out + i*sizeof(W), s[i][l]);
+      }
+    }
+    return;
+  }
+  for (i=0;i<10;i++) _store_le<W> (b + i*sizeof(W), s[i][l]);
+  for (i=0;i<n;i++) {
+    if (mode==NORX_MODE_DECRYPT) {
+      v = in[i];
+      out[i] = b[i] ^ v;
+      b[i] = v;
+    } else {
+      b[i] ^= in[i];
+      if (mode==NORX_MODE_ENCRYPT) out[i] = b[i];
+    }
+  }
+  b[n] ^= 0x01;
+  b[rate-1] ^= 0x80;
+  for (i=0;i<10;i++) s[i][l] = _load_le<W> (b + i*sizeof(W));
+}
+
+/***************************************************************************
+ * batch engine
+ */
+
+NorxBatch::NorxBatch (Norx* norx) {
+  this->norx = norx;
+}
+
+template <typename W, uint8_t L>
+void NorxBatch::_run (uint8_t bits, norx_job_t* jobs, size_t n, uint8_t mode) {
+  static const uint8_t tags[] = { 0, 0, NORX_TAG_HEADER, NORX_TAG_PAYLOAD, NORX_TAG_TRAILER, NORX_TAG_FINAL, 0 };
+  const uint8_t rate = 10 * sizeof(W);
+  const uint8_t wb = sizeof(W);
+  void (*permute) (W s[16][L], uint8_t r) = _permute_lanes<W, L>;
+  W s[16][L];
+  lane_t lane[L];
+  state_t st;
+  stw k[4], nn[2];
+  size_t next = 0, c = 0;
+  uint8_t active, l, i, d;
+  uint8_t t[NORX_MAX_TAG_SIZE];
+  norx_job_t* j;
+
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2")) permute = _permute_lanes_avx2<W, L>;
+#endif
+  memset (s, 0, sizeof(s));
+  memset (lane, 0, sizeof(lane));
+
+  for (;;) {
+    // before F^R : refill idle lanes, inject the domain tags
+    active = 0;
+    for (l=0;l<L;l++) {
+      if ((lane[l].stage==LANE_IDLE)&&(next<n)) {
+        j = &(jobs[next++]);
+        for (i=0;i<4;i++) this->norx->_load_word (bits, &(k[i]), j->key + i*wb);
+        for (i=0;i<2;i++) this->norx->_load_word (bits, &(nn[i]), j->nonce + i*wb);
+        this->norx->_setup (&st, bits, this->norx->rounds, 1, bits*4, k, nn);
+        for (i=0;i<16;i++) s[i][l] = _word (&st, i, (W*)0);
+        lane[l].job = j;
+        lane[l].stage = LANE_INIT;
+        lane[l].off = 0;
+      }
+      if (lane[l].stage!=LANE_IDLE) active++;
+      s[15][l] ^= tags[lane[l].stage];
+    }
+    if (!active) break;
+
+    permute (s, this->norx->rounds);
+
+    // after F^R : each lane absorbs its block or moves on
+    for (l=0;l<L;l++) {
+      j = lane[l].job;
+      switch (lane[l].stage) {
+        case LANE_IDLE :
+          continue;
+        case LANE_HEADER :
+          c = min ((size_t)rate, j->hlen - lane[l].off);
+          _block<W, L> (s, l, j->h + lane[l].off, NULL, c, NORX_MODE_ABSORB);
+          break;
+        case LANE_PAYLOAD :
+          c = min ((size_t)rate, j->len - lane[l].off);
+          _block<W, L> (s, l, j->in + lane[l].off, j->out + lane[l].off, c, mode);
+          break;
+        case LANE_TRAILER :
+          c = min ((size_t)rate, j->tlen - lane[l].off);
+          _block<W, L> (s, l, j->t + lane[l].off, NULL, c, NORX_MODE_ABSORB);
+          break;
+        case LANE_INIT :
+          lane[l].stage = _next_stage (j, LANE_INIT);
+          continue;
+        case LANE_FINAL1 :
+          lane[l].stage = LANE_FINAL2;
+          continue;
+        case LANE_FINAL2 :
+          for (i=0;i<4;i++) _store_le<W> (t + i*wb, s[i][l]);
+          if (mode==NORX_MODE_DECRYPT) {
+            for (i=0,d=0;i<4*wb;i++) d |= t[i] ^ j->tag[i];
+            j->ok = (1 & ((d - 1) >> 8));
+            NORX_CT_PUBLIC (&(j->ok), sizeof(j->ok));
+            if (!j->ok) memset (j->out, 0, j->len);
+          } else
+            memcpy (j->tag, t, 4*wb);
+          for (i=0;i<16;i++) s[i][l] = 0;
+          lane[l].stage = LANE_IDLE;
+          continue;
+      }
+      // data stages, a short block closes the stage
+      lane[l].off += c;
+      if (c<rate) {
+        lane[l].stage = _next_stage (j, lane[l].stage);
+        lane[l].off = 0;
+      }
+    }
+  }
+  memset (t, 0, sizeof(t));
+  memset (k, 0, sizeof(k));
+  memset (&st, 0, sizeof(st));
+}
+
+bool NorxBatch::encrypt (uint8_t bits, norx_job_t* jobs, size_t n) {
+  if (this->norx->d!=1) return 0;
+  if (bits==32) this->_run<uint32_t, 8> (bits, jobs, n, NORX_MODE_ENCRYPT);
+#if NORX_64
+  else if (bits==64) this->_run<uint64_t, 4> (bits, jobs, n, NORX_MODE_ENCRYPT);
+#endif
+  else return 0;
+  return 1;
+}
+
+bool NorxBatch::decrypt (uint8_t bits, norx_job_t* jobs, size_t n) {
+  if (this->norx->d!=1) return 0;
+  if (bits==32) this->_run<uint32_t, 8> (bits, jobs, n, NORX_MODE_DECRYPT);
+#if NORX_64
+  else if (bits==64) this->_run<uint64_t, 4> (bits, jobs, n, NORX_MODE_DECRYPT);
+#endif
+  else return 0;
+  return 1;
+}
+
+/***************************************************************************
+ * test procedure, a ragged batch against the one shot path
+ */
+
+#define BATCH_TEST_JOBS 11
+#define BATCH_TEST_MAX  170
+
+bool NorxBatch::test (void) {
+  static uint8_t key[BATCH_TEST_JOBS][32];
+  static uint8_t nonce[BATCH_TEST_JOBS][16];
+  static uint8_t m[BATCH_TEST_JOBS][BATCH_TEST_MAX];
+  static uint8_t c[BATCH_TEST_JOBS][BATCH_TEST_MAX];
+  static uint8_t e[BATCH_TEST_MAX + NORX_MAX_TAG_SIZE];
+  static uint8_t tag[BATCH_TEST_JOBS][NORX_MAX_TAG_SIZE];
+  const uint8_t h[] = "batch header";
+  norx_job_t jobs[BATCH_TEST_JOBS];
+  uint8_t bits, i, b, d;
+  bool ok = 1, r;
+
+  for (bits=32;bits<=NORX_MAX_BITS;bits+=32) {
+    Serial.print (F("* Testing batch_"));
+    Serial.println (bits);
+    r = 1;
+    for (i=0;i<BATCH_TEST_JOBS;i++) {
+      for (b=0;b<32;b++) key[i][b] = i * 31 + b;
+      for (b=0;b<16;b++) nonce[i][b] = i ^ b;
+      jobs[i].key = key[i];
+      jobs[i].nonce = nonce[i];
+      jobs[i].h = h;
+      jobs[i].hlen = i % 4;
+      jobs[i].in = m[i];
+      jobs[i].out = c[i];
+      jobs[i].len = (i * 37) % BATCH_TEST_MAX;
+      jobs[i].t = h;
+      jobs[i].tlen = i % 3;
+      jobs[i].tag = tag[i];
+      for (b=0;b<BATCH_TEST_MAX;b++) m[i][b] = i + b * 3;
+    }
+    r &= this->encrypt (bits, jobs, BATCH_TEST_JOBS);
+    for (i=0;i<BATCH_TEST_JOBS;i++) {
+      this->norx->encrypt (bits, key[i], nonce[i], h, jobs[i].hlen, m[i], jobs[i].len, h, jobs[i].tlen, e);
+      r &= (memcmp (e, c[i], jobs[i].len)==0);
+      r &= (memcmp (e + jobs[i].len, tag[i], bits>>1)==0);
+    }
+
+    // in place decryption, one forged tag
+    tag[5][0] ^= 0x01;
+    for (i=0;i<BATCH_TEST_JOBS;i++) jobs[i].in = c[i];
+    r &= this->decrypt (bits, jobs, BATCH_TEST_JOBS);
+    for (i=0;i<BATCH_TEST_JOBS;i++) {
+      if (i==5) {
+        r &= !jobs[i].ok;
+        continue;
+      }
+      r &= jobs[i].ok;
+      r &= (memcmp (m[i], c[i], jobs[i].len)==0);
+    }
+
+    // the lanes of D>1 are not batched
+    d = this->norx->d;
+    this->norx->d = 2;
+    r &= !this->encrypt (bits, jobs, BATCH_TEST_JOBS);
+    this->norx->d = d;
+    ok &= _TEST (r);
+  }
+  return ok;
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef __norx_batch_h_
+#define __norx_batch_h_
+
+#include "norx.h"
+
+/***************************************************************************
+ * batched AEAD over independent messages
+ *
+ * for gateways checking many short messages, each with its own key and
+ * nonce. the states of up to 8 (NORX32) or 4 (NORX64) messages are kept
+ * transposed, word i of every lane side by side, so that F^R runs on all
+ * of them at once in 256 bit vectors (AVX2 when the CPU has it, SSE2
+ * otherwise). every step runs one F^R on all lanes, each lane then absorbs
+ * its own block and moves on; a lane whose message is done takes the next
+ * job, so messages of different lengths share the lanes and only the tail
+ * of the batch runs partly empty. tags are the same as Norx's one shot
+ * path, with the rounds of the Norx instance given to the constructor.
+ * messages are sequential (D=1) : encrypt and decrypt return 0 and leave
+ * the jobs alone when the instance has another D, or the width is not
+ * built in.
+ *
+ * host only, NORX_BATCH=0 leaves it out.
+ */
+
+#ifndef NORX_BATCH
+#if defined(__GNUC__) && !defined(__AVR__)
+#define NORX_BATCH 1
+#else
+#define NORX_BATCH 0
+#endif
+#endif
+
+#if NORX_BATCH
+
+typedef struct {
+  const uint8_t* key;
+  const uint8_t* nonce;
+  const uint8_t* h;
+  size_t         hlen;
+  const uint8_t* in;
+  uint8_t*       out;
+  size_t         len;
+  const uint8_t* t;
+  size_t         tlen;
+  uint8_t*       tag;   // written by encrypt, checked by decrypt
+  bool           ok;    // decrypt result, out is wiped when 0
+} norx_job_t;
+
+class NorxBatch {
+  private :
+    Norx* norx;
+
+    template <typename W, uint8_t L>
+    void _run (uint8_t bits, norx_job_t* jobs, size_t n, uint8_t mode);
+
+  public :
+    NorxBatch (Norx* norx);
+    bool encrypt (uint8_t bits, norx_job_t* jobs, size_t n);
+    bool decrypt (uint8_t bits, norx_job_t* jobs, size_t n);
+    bool test (void);
+};
+
+#endif
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef __norx_bi64_h_
+#define __norx_bi64_h_
+
+#include <stdint.h>
+
+/***************************************************************************
+ * bit interleaved NORX64, for 32 and 8 bit CPUs
+ *
+ * a 64 bit word x is held as two 32 bit halves, e its even bits and o its
+ * odd bits, so that every operation of G is on 32 bit words :
+ *   ROR 2k      both halves ROR k                       (8, 40)
+ *   ROR 2k+1    e' = o ROR k, o' = e ROR k+1            (19, 63)
+ *   x << 1      e' = o << 1, o' = e                     (in H)
+ * ROR 63 is then a swap of the halves and a ROR 31, where uint64_t makes
+ * gcc shift and or across two or eight registers.
+ *
+ * the state is interleaved when F^R starts and put back when it ends, as
+ * the rate, the tag, the lanes and save () address it as bytes : sixteen
+ * words each way, a few hundred 32 bit operations against the 8 R Gs.
+ * NORX_BI64=1 routes F^R of NORX64 here, it is the default where pointers
+ * are narrower than 64 bits. the vectorized F (norx_simd.h) still comes
+ * first when there is one.
+ */
+
+#ifndef NORX_BI64
+#if defined(__AVR__) || (defined(__SIZEOF_POINTER__) && (__SIZEOF_POINTER__ < 8))
+#define NORX_BI64 1
+#else
+#define NORX_BI64 0
+#endif
+#endif
+
+template <uint8_t R>
+class NorxBi64 {
+  private :
+    template <uint8_t n>
+    static inline uint32_t ROR32 (uint32_t x) {
+      return (x >> n) | (x << ((32 - n) & 31));
+    }
+
+    // even bits to the low half, odd bits to the high half
+    static inline uint32_t unzip (uint32_t x) {
+      uint32_t t;
+      t = (x ^ (x >> 1)) & 0x22222222UL; x ^= t ^ (t << 1);
+      t = (x ^ (x >> 2)) & 0x0c0c0c0cUL; x ^= t ^ (t << 2);
+      t = (x ^ (x >> 4)) & 0x00f000f0UL; x ^= t ^ (t << 4);
+      t = (x ^ (x >> 8)) & 0x0000ff00UL; x ^= t ^ (t << 8);
+      return x;
+    }
+
+    static inline uint32_t zip (uint32_t x) {
+      uint32_t t;
+      t = (x ^ (x >> 8)) & 0x0000ff00UL; x ^= t ^ (t << 8);
+      t = (x ^ (x >> 4)) & 0x00f000f0UL; x ^= t ^ (t << 4);
+      t = (x ^ (x >> 2)) & 0x0c0c0c0cUL; x ^= t ^ (t << 2);
+      t = (x ^ (x >> 1)) & 0x22222222UL; x ^= t ^ (t << 1);
+      return x;
+    }
+
+    // a = (a ^ b) ^ ((a & b) << 1)
+    static inline void H (uint32_t& ae, uint32_t& ao, uint32_t be, uint32_t bo) {
+      uint32_t t = ae & be;
+      ae = (ae ^ be) ^ ((ao & bo) << 1);
+      ao = (ao ^ bo) ^ t;
+    }
+
+    template <uint8_t n>
+    static inline void ROR (uint32_t& e, uint32_t& o) {
+      uint32_t t = e;
+      if (n & 1) {
+        e = ROR32<(n >> 1)> (o);
+        o = ROR32<((n >> 1) + 1) & 31> (t);
+      } else {
+        e = ROR32<(n >> 1)> (e);
+        o = ROR32<(n >> 1)> (o);
+      }
+    }
+
+  public :
+    static inline void split (uint64_t x, uint32_t& e, uint32_t& o) {
+      uint32_t lo = unzip ((uint32_t)x), hi = unzip ((uint32_t)(x >> 32));
+      e = (lo & 0xffffUL) | (hi << 16);
+      o = (lo >> 16) | (hi & 0xffff0000UL);
+    }
+
+    static inline uint64_t join (uint32_t e, uint32_t o) {
+      uint32_t lo = zip ((e & 0xffffUL) | (o << 16));
+      uint32_t hi = zip ((e >> 16) | (o & 0xffff0000UL));
+      return ((uint64_t)hi << 32) | lo;
+    }
+
+    static inline void G (uint32_t* e, uint32_t* o, uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+      H (e[a], o[a], e[b], o[b]); e[d] ^= e[a]; o[d] ^= o[a]; ROR<8> (e[d], o[d]);
+      H (e[c], o[c], e[d], o[d]); e[b] ^= e[c]; o[b] ^= o[c]; ROR<19> (e[b], o[b]);
+      H (e[a], o[a], e[b], o[b]); e[d] ^= e[a]; o[d] ^= o[a]; ROR<40> (e[d], o[d]);
+      H (e[c], o[c], e[d], o[d]); e[b] ^= e[c]; o[b] ^= o[c]; ROR<63> (e[b], o[b]);
+    }
+
+    static inline void round (uint32_t* e, uint32_t* o) {
+      G (e, o, 0, 4,  8, 12);
+      G (e, o, 1, 5,  9, 13);
+      G (e, o, 2, 6, 10, 14);
+      G (e, o, 3, 7, 11, 15);
+      G (e, o, 0, 5, 10, 15);
+      G (e, o, 1, 6, 11, 12);
+      G (e, o, 2, 7,  8, 13);
+      G (e, o, 3, 4,  9, 14);
+    }
+
+    // F^r on s, R rounds unless told otherwise
+    static inline void permute (uint64_t* s, uint8_t r = R) {
+      uint32_t e[16], o[16];
+      uint8_t i;
+      for (i=0;i<16;i++) split (s[i], e[i], o[i]);
+      for (i=0;i<r;i++) round (e, o);
+      for (i=0;i<16;i++) s[i] = join (e[i], o[i]);
+    }
+};
+
+typedef NorxBi64<1> NorxBi64F;
+
+#endif
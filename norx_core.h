@@ -0,0 +1,93 @@
+#ifndef __norx_core_h_
+#define __norx_core_h_
+
+#include <stdint.h>
+
+/***************************************************************************
+ * compile-time specialized NORX core
+ * W => word type (uint8_t to uint64_t)
+ * R => number of rounds of F applied by permute
+ *
+ * everything here is static and inline, so that F^R compiles to straight
+ * line code working on sixteen local words, with no branches on the word
+ * width and no round trip through the stw union
+ */
+
+template <typename W> struct NorxWord;
+
+// NORX8 and NORX16, the small variants
+template <> struct NorxWord<uint8_t> {
+  enum { bits = 8, r0 = 1, r1 = 3, r2 = 5, r3 = 7 };
+};
+
+template <> struct NorxWord<uint16_t> {
+  enum { bits = 16, r0 = 8, r1 = 11, r2 = 12, r3 = 15 };
+};
+
+template <> struct NorxWord<uint32_t> {
+  enum { bits = 32, r0 = 8, r1 = 11, r2 = 16, r3 = 31 };
+};
+
+template <> struct NorxWord<uint64_t> {
+  enum { bits = 64, r0 = 8, r1 = 19, r2 = 40, r3 = 63 };
+};
+
+/* G, generic version. norx_avr.h specializes it for NORX32 on AVR */
+template <typename W>
+struct NorxG {
+  typedef NorxWord<W> word;
+
+  static inline W H (W a, W b) {
+    return (a ^ b) ^ ((a & b) << 1);
+  }
+
+  template <uint8_t n>
+  static inline W ROR (W x) {
+    return (x >> n) | (x << (word::bits - n));
+  }
+
+  static inline void G (W& a, W& b, W& c, W& d) {
+    a = H (a, b); d = ROR<word::r0> (a ^ d);
+    c = H (c, d); b = ROR<word::r1> (b ^ c);
+    a = H (a, b); d = ROR<word::r2> (a ^ d);
+    c = H (c, d); b = ROR<word::r3> (b ^ c);
+  }
+};
+
+#include "norx_avr.h"
+
+template <typename W, uint8_t R>
+class NorxCore {
+  public :
+    static inline void G (W& a, W& b, W& c, W& d) {
+      NorxG<W>::G (a, b, c, d);
+    }
+
+    // one round of F, columns then diagonals
+    static inline void round (W* x) {
+      G (x[0], x[4], x[ 8], x[12]);
+      G (x[1], x[5], x[ 9], x[13]);
+      G (x[2], x[6], x[10], x[14]);
+      G (x[3], x[7], x[11], x[15]);
+      G (x[0], x[5], x[10], x[15]);
+      G (x[1], x[6], x[11], x[12]);
+      G (x[2], x[7], x[ 8], x[13]);
+      G (x[3], x[4], x[ 9], x[14]);
+    }
+
+    // F^R on s, working on a local copy so the words stay in registers
+    static inline void permute (W* s) {
+      W x[16];
+      uint8_t i;
+      for (i=0;i<16;i++) x[i] = s[i];
+      for (i=0;i<R;i++) round (x);
+      for (i=0;i<16;i++) s[i] = x[i];
+    }
+};
+
+typedef NorxCore<uint8_t, 1> Norx8F;
+typedef NorxCore<uint16_t, 1> Norx16F;
+typedef NorxCore<uint32_t, 1> Norx32F;
+typedef NorxCore<uint64_t, 1> Norx64F;
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef __norx_ct_h_
+#define __norx_ct_h_
+
+/***************************************************************************
+ * constant time audit marks
+ *
+ * with NORX_CTGRIND=1 (host only, needs valgrind/memcheck.h) the bytes
+ * given to NORX_CT_SECRET are made undefined for memcheck, which then
+ * reports every branch and every address computed from them. results
+ * that are meant to be public, like the outcome of a tag comparison, go
+ * through NORX_CT_PUBLIC. otherwise both compile to nothing.
+ *
+ * the rotation and shift counts (_ROR_*, _SHL_*, NorxG::ROR) are public
+ * constants : on AVR a shift by a runtime n is a loop, which is fine as
+ * long as n never depends on a key or a message.
+ *
+ * see host/ct.cpp, make ct and make ctgrind
+ */
+
+#ifndef NORX_CTGRIND
+#define NORX_CTGRIND 0
+#endif
+
+#if NORX_CTGRIND && defined(__has_include)
+#if !__has_include(<valgrind/memcheck.h>)
+#error "NORX_CTGRIND needs valgrind/memcheck.h"
+#endif
+#endif
+
+#if NORX_CTGRIND
+#include <valgrind/memcheck.h>
+#define NORX_CT_SECRET(p, len) VALGRIND_MAKE_MEM_UNDEFINED ((p), (len))
+#define NORX_CT_PUBLIC(p, len) VALGRIND_MAKE_MEM_DEFINED ((p), (len))
+#else
+#define NORX_CT_SECRET(p, len)
+#define NORX_CT_PUBLIC(p, len)
+#endif
+
+#endif
@@ -0,0 +1,179 @@
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "norx_drbg.h"
+#include "cryptoutils.h"
+
+NorxDrbg::NorxDrbg (Norx* norx) {
+  this->x = norx;
+  this->wipe ();
+}
+
+/***************************************************************************
+ * the sponge
+ */
+
+/* p through the rate, a block per F^R, the last one padded (and empty
+   when len is a whole number of blocks) */
+void NorxDrbg::_absorb (const uint8_t* p, size_t len, uint8_t tag) {
+  uint8_t rate = this->x->_rate (&(this->s));
+  uint8_t i, n;
+
+  for (;;) {
+    n = (len<rate) ? len : rate;
+    this->x->_inject (&(this->s), tag);
+    this->x->_permute (&(this->s), this->s.rounds);
+    for (i=0;i<n;i++) *(this->x->_rate_byte (&(this->s), i)) ^= p[i];
+    p += n;
+    len -= n;
+    if (n<rate) break;
+  }
+  *(this->x->_rate_byte (&(this->s), n)) ^= 0x01;
+  *(this->x->_rate_byte (&(this->s), rate - 1)) ^= 0x80;
+}
+
+/* a rate block into buf, then the rate is forgotten */
+void NorxDrbg::_squeeze (void) {
+  uint8_t rate = this->x->_rate (&(this->s));
+  uint8_t* r = this->x->_rate_byte (&(this->s), 0);
+
+  this->x->_inject (&(this->s), NORX_DRBG_SQUEEZE);
+  this->x->_permute (&(this->s), this->s.rounds);
+  memcpy (this->buf, r, rate);
+  memset (r, 0, rate);
+  this->pos = 0;
+  this->blocks++;
+}
+
+/***************************************************************************
+ * public API
+ */
+
+bool NorxDrbg::seed (uint8_t bits, const uint8_t* e, size_t len,
+                     const uint8_t* pers, size_t plen) {
+  if ((bits!=32)&&(bits!=NORX_MAX_BITS)) return 0;
+  if (len<(size_t)(bits>>1)) return 0;
+  this->wipe ();
+  this->s.bits = bits;
+  this->s.rounds = this->x->rounds;
+  this->ratchet ();
+  this->_absorb (e, len, NORX_DRBG_SEED);
+  if (plen) this->_absorb (pers, plen, NORX_DRBG_STRING);
+  this->seeded = 1;
+  return 1;
+}
+
+bool NorxDrbg::reseed (const uint8_t* e, size_t len,
+                       const uint8_t* ad, size_t alen) {
+  if (!this->seeded) return 0;
+  if (len<(size_t)(this->s.bits>>1)) return 0;
+  this->ratchet ();
+  this->_absorb (e, len, NORX_DRBG_SEED);
+  if (alen) this->_absorb (ad, alen, NORX_DRBG_STRING);
+  this->blocks = 0;
+  return 1;
+}
+
+/* served from buf, a block is squeezed whenever it runs out. additional
+   input drops what is left of buf first */
+bool NorxDrbg::generate (uint8_t* out, size_t len,
+                         const uint8_t* ad, size_t alen) {
+  uint8_t rate = this->x->_rate (&(this->s));
+  uint8_t n;
+
+  if ((!this->seeded)||(this->blocks>=NORX_DRBG_RESEED)) return 0;
+  if (alen) {
+    this->ratchet ();
+    this->_absorb (ad, alen, NORX_DRBG_STRING);
+  }
+  while (len) {
+    if (this->pos==rate) {
+      if (this->blocks>=NORX_DRBG_RESEED) return 0;
+      this->_squeeze ();
+    }
+    n = ((size_t)(rate - this->pos) < len) ? rate - this->pos : len;
+    memcpy (out, this->buf + this->pos, n);
+    memset (this->buf + this->pos, 0, n);
+    this->pos += n;
+    out += n;
+    len -= n;
+  }
+  return 1;
+}
+
+/* forgets the output not served yet, the next request squeezes anew */
+void NorxDrbg::ratchet (void) {
+  memset (this->buf, 0, sizeof(this->buf));
+  this->pos = this->x->_rate (&(this->s));
+}
+
+void NorxDrbg::wipe (void) {
+  memset (&(this->s), 0, sizeof(this->s));
+  this->s.bits = 32;
+  this->ratchet ();
+  this->blocks = 0;
+  this->seeded = 0;
+}
+
+/***************************************************************************
+ * test procedure
+ */
+
+// CRC-32 of the first 100 bytes, R 4, entropy 0 to 47 and pers "drbg"
+// (host/kat/genkat.py --drbg)
+const uint32_t DRBG_TEST_CRC[2] PROGMEM = { 0x1edcb1c2UL, 0x3ab57a94UL };
+
+#define DRBG_TEST_LEN 100
+
+bool NorxDrbg::test (void) {
+  const uint8_t pers[] = "drbg";
+  const uint8_t sizes[] = { 1, 3, 7, 40, 80, 4 };
+  uint8_t e[48], a[DRBG_TEST_LEN], b[DRBG_TEST_LEN];
+  uint8_t saved = this->x->rounds;
+  uint8_t bits, i, n, rate;
+  bool ok = 1, r;
+
+  for (i=0;i<sizeof(e);i++) e[i] = i;
+  this->x->rounds = 4;
+  for (bits=32;bits<=NORX_MAX_BITS;bits+=32) {
+    Serial.print (F("* Testing drbg_"));
+    Serial.println (bits);
+    rate = 10 * (bits >> 3);
+    // the model's output, whole and in odd sized requests
+    r = this->seed (bits, e, sizeof(e), pers, sizeof(pers)-1);
+    r &= this->generate (a, DRBG_TEST_LEN);
+    r &= (crc32 (0, a, DRBG_TEST_LEN)==pgm_read_dword (&(DRBG_TEST_CRC[(bits>>5)-1])));
+    this->seed (bits, e, sizeof(e), pers, sizeof(pers)-1);
+    for (i=0,n=0;n<DRBG_TEST_LEN;n+=sizes[i%sizeof(sizes)],i++)
+      this->generate (b + n, min (sizes[i%sizeof(sizes)], DRBG_TEST_LEN - n));
+    r &= (memcmp (a, b, DRBG_TEST_LEN)==0);
+    // forgotten : the rate of the state and the bytes served
+    for (i=0;i<rate;i++) r &= (*(this->x->_rate_byte (&(this->s), i))==0);
+    for (i=0;i<this->pos;i++) r &= (this->buf[i]==0);
+    // additional input, reseed and ratchet each change what follows
+    this->seed (bits, e, sizeof(e), pers, sizeof(pers)-1);
+    this->generate (b, 4, pers, sizeof(pers)-1);
+    r &= (memcmp (a, b, 4)!=0);
+    this->seed (bits, e, sizeof(e), pers, sizeof(pers)-1);
+    this->reseed (e, sizeof(e));
+    this->generate (b, 4);
+    r &= (memcmp (a, b, 4)!=0);
+    this->seed (bits, e, sizeof(e), pers, sizeof(pers)-1);
+    this->generate (b, 4);
+    this->ratchet ();
+    this->generate (b, 4);
+    r &= (memcmp (a + 4, b, 4)!=0)&&(memcmp (a + rate, b, 4)==0);
+    // refusals : short entropy, unseeded, reseed due
+    r &= !this->seed (bits, e, (bits>>1) - 1);
+    this->wipe ();
+    r &= !this->generate (b, 1);
+    this->seed (bits, e, sizeof(e));
+    this->blocks = NORX_DRBG_RESEED - 1;
+    r &= this->generate (b, rate);
+    r &= !this->generate (b, 1);
+    r &= this->reseed (e, sizeof(e))&&this->generate (b, 1);
+    ok &= _TEST (r);
+  }
+  this->wipe ();
+  this->x->rounds = saved;
+  return ok;
+}
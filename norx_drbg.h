@@ -0,0 +1,67 @@
+#ifndef __norx_drbg_h_
+#define __norx_drbg_h_
+
+#include "norx.h"
+
+/***************************************************************************
+ * deterministic random bit generator, a duplex sponge on F^R
+ *
+ * the state is a NORX32 or NORX64 one of its own, zero to begin with, run
+ * at the rounds of the Norx instance. seed and reseed absorb the entropy
+ * and an optional string a rate block at a time, padded as NORX pads, each
+ * block after an F^R with a domain tag in word 15 :
+ *   NORX_DRBG_SEED      entropy
+ *   NORX_DRBG_STRING    personalization or additional input
+ *   NORX_DRBG_SQUEEZE   one block of output
+ * output is squeezed a whole rate block (40 or 80 bytes) at a time into
+ * buf and requests are served from there, so that a 4 byte nonce costs a
+ * tenth or a twentieth of an F^R.
+ *
+ * the rate of the state is zeroed as soon as it is copied out, and each
+ * byte of buf once served : whoever reads the object later has the
+ * capacity and zeros, and cannot run F^R back to what was given out
+ * before (forward security). ratchet drops the bytes not served yet too.
+ * on AVR an instance takes 218 bytes of RAM, 114 with NORX_64=0.
+ *
+ * generate returns 0 before seed, and after NORX_DRBG_RESEED blocks until
+ * the next reseed. seed and reseed refuse entropy shorter than the tag,
+ * 16 or 32 bytes. this is not an SP 800-90A construction, its known
+ * answers (host/kat/genkat.py --drbg) come from this library's model
+ */
+
+#define NORX_DRBG_SEED    0x40
+#define NORX_DRBG_STRING  0x41
+#define NORX_DRBG_SQUEEZE 0x42
+
+// output blocks between reseeds
+#ifndef NORX_DRBG_RESEED
+#define NORX_DRBG_RESEED  (1UL << 20)
+#endif
+
+class NorxDrbg {
+  private :
+    Norx* x;
+    state_t s;
+    uint8_t buf[10*(NORX_MAX_BITS>>3)];
+    uint8_t pos;
+    uint32_t blocks;
+    bool seeded;
+
+    void _absorb (const uint8_t* p, size_t len, uint8_t tag);
+    void _squeeze (void);
+
+  public :
+    NorxDrbg (Norx* norx);
+
+    bool seed (uint8_t bits, const uint8_t* e, size_t len,
+               const uint8_t* pers = NULL, size_t plen = 0);
+    bool reseed (const uint8_t* e, size_t len,
+                 const uint8_t* ad = NULL, size_t alen = 0);
+    bool generate (uint8_t* out, size_t len,
+                   const uint8_t* ad = NULL, size_t alen = 0);
+    void ratchet (void);
+    void wipe (void);
+    bool test (void);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "norx_pool.h"
+
+#if NORX_THREADS
+
+#include <pthread.h>
+#include <unistd.h>
+#include "norx.h"
+
+static pthread_once_t  pool_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t pool_run  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  pool_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  pool_done = PTHREAD_COND_INITIALIZER;
+
+static uint8_t     pool_threads = 1;
+static uint32_t    pool_gen = 0;
+static norx_task_t pool_task;
+static void*       pool_arg;
+static uint8_t     pool_next;
+static uint8_t     pool_n;
+static uint8_t     pool_left;
+
+/* takes tasks of the current run until there are none left, lock held */
+static void _pool_drain (void) {
+  uint8_t i;
+  while (pool_next<pool_n) {
+    i = pool_next++;
+    pthread_mutex_unlock (&pool_lock);
+    pool_task (pool_arg, i);
+    pthread_mutex_lock (&pool_lock);
+    if (--pool_left==0) pthread_cond_signal (&pool_done);
+  }
+}
+
+static void* _pool_worker (void* unused) {
+  uint32_t gen = 0;
+  pthread_mutex_lock (&pool_lock);
+  for (;;) {
+    while (gen==pool_gen) pthread_cond_wait (&pool_work, &pool_lock);
+    gen = pool_gen;
+    _pool_drain ();
+  }
+  return NULL;
+}
+
+static void _pool_start (void) {
+  long cpus = NORX_POOL_SIZE ? NORX_POOL_SIZE : sysconf (_SC_NPROCESSORS_ONLN);
+  pthread_t t;
+  if (cpus>NORX_MAX_LANES) cpus = NORX_MAX_LANES;
+  while (pool_threads<cpus) {
+    if (pthread_create (&t, NULL, _pool_worker, NULL)) break;
+    pthread_detach (t);
+    pool_threads++;
+  }
+}
+
+uint8_t norx_pool_size (void) {
+  pthread_once (&pool_once, _pool_start);
+  return pool_threads;
+}
+
+void norx_pool_run (norx_task_t task, void* arg, uint8_t n) {
+  pthread_once (&pool_once, _pool_start);
+  pthread_mutex_lock (&pool_run);
+  pthread_mutex_lock (&pool_lock);
+  pool_task = task;
+  pool_arg = arg;
+  pool_next = 0;
+  pool_n = n;
+  pool_left = n;
+  pool_gen++;
+  pthread_cond_broadcast (&pool_work);
+  _pool_drain ();
+  while (pool_left) pthread_cond_wait (&pool_done, &pool_lock);
+  pthread_mutex_unlock (&pool_lock);
+  pthread_mutex_unlock (&pool_run);
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef __norx_pool_h_
+#define __norx_pool_h_
+
+#include "Arduino.h"
+
+/***************************************************************************
+ * host thread pool for the parallel payload lanes (D>1 or D=0)
+ *
+ * the workers are started on first use, one per online CPU (or
+ * NORX_POOL_SIZE) minus the caller, which takes its share of the tasks
+ * too. calls from several threads are serialized. NORX_THREADS=0 leaves
+ * it out, the lanes are then processed one block at a time like on the
+ * board.
+ */
+
+#ifndef NORX_THREADS
+#if defined(ARDUINO_HOST) && defined(__linux__)
+#define NORX_THREADS 1
+#else
+#define NORX_THREADS 0
+#endif
+#endif
+
+// threads in the pool, 0 is one per online CPU
+#ifndef NORX_POOL_SIZE
+#define NORX_POOL_SIZE 0
+#endif
+
+// smallest payload update spread over the pool, below it the lanes are
+// run by the caller
+#ifndef NORX_THREADS_MIN
+#define NORX_THREADS_MIN 16384
+#endif
+
+#if NORX_THREADS
+
+typedef void (*norx_task_t) (void* arg, uint8_t i);
+
+// number of threads working on a run, caller included
+uint8_t norx_pool_size (void);
+
+// runs task (arg, i) for i in 0..n-1, returns once they are all done
+void norx_pool_run (norx_task_t task, void* arg, uint8_t n);
+
+#endif
+
+#endif
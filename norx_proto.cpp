@@ -0,0 +1,229 @@
+#include <string.h>
+#include "norx_proto.h"
+#include "cryptoutils.h"
+
+// parser states
+#define RX_HUNT  0
+#define RX_CMD   1
+#define RX_LEN   2
+#define RX_DATA  3
+#define RX_CRC   4
+#define RX_FULL  5   // rx holds a frame, ready too
+
+NorxProto::NorxProto (Norx* norx) {
+  this->norx = norx;
+  memset (&(this->ctx), 0, sizeof(this->ctx));
+  this->keyed = 0;
+  this->started = 0;
+  this->rx_state = RX_HUNT;
+  this->rx = &(this->frames[0]);
+  this->ready = NULL;
+  this->tx_len = 0;
+  this->tx_pos = 0;
+}
+
+/* one byte through the parser, true once rx holds a whole frame. a bad
+   frame comes out as NORX_CMD_ERROR with the status as its only byte */
+bool NorxProto::_receive (uint8_t c) {
+  norx_frame_t* f = this->rx;
+  uint8_t h[3];
+  uint32_t crc;
+
+  switch (this->rx_state) {
+    case RX_HUNT :
+      if (c==NORX_PROTO_SOF) this->rx_state = RX_CMD;
+      return 0;
+    case RX_CMD :
+      f->cmd = c;
+      f->len = 0;
+      this->rx_n = 0;
+      this->rx_state = RX_LEN;
+      return 0;
+    case RX_LEN :
+      f->len |= (uint16_t)c << (8 * this->rx_n);
+      if (++this->rx_n<2) return 0;
+      if (f->len>NORX_PROTO_MAX) {
+        this->rx_state = RX_HUNT;
+        f->cmd = NORX_CMD_ERROR;
+        f->len = 1;
+        f->data[0] = NORX_PROTO_LENGTH;
+        return 1;
+      }
+      this->rx_pos = 0;
+      this->rx_n = 0;
+      this->rx_crc = 0;
+      this->rx_state = f->len ? RX_DATA : RX_CRC;
+      return 0;
+    case RX_DATA :
+      f->data[this->rx_pos++] = c;
+      if (this->rx_pos==f->len) this->rx_state = RX_CRC;
+      return 0;
+    case RX_CRC :
+      this->rx_crc |= (uint32_t)c << (8 * this->rx_n);
+      if (++this->rx_n<4) return 0;
+      this->rx_state = RX_HUNT;
+      h[0] = f->cmd;
+      h[1] = f->len;
+      h[2] = f->len >> 8;
+      crc = crc32 (crc32 (0, h, 3), f->data, f->len);
+      if (crc!=this->rx_crc) {
+        f->cmd = NORX_CMD_ERROR;
+        f->len = 1;
+        f->data[0] = NORX_PROTO_CRC;
+      }
+      return 1;
+  }
+  return 0;
+}
+
+/* frames the len bytes of data already at tx + 5 */
+void NorxProto::_reply (uint8_t cmd, uint8_t status, uint16_t len) {
+  uint32_t crc;
+  uint8_t i;
+  len++;
+  this->tx[0] = NORX_PROTO_SOF;
+  this->tx[1] = cmd;
+  this->tx[2] = len;
+  this->tx[3] = len >> 8;
+  this->tx[4] = status;
+  crc = crc32 (0, this->tx + 1, 3 + len);
+  for (i=0;i<4;i++) this->tx[4 + len + i] = crc >> (8*i);
+  this->tx_len = 4 + len + 4;
+  this->tx_pos = 0;
+}
+
+/* as much of the reply as the UART takes without waiting */
+bool NorxProto::_send (void) {
+  int room = Serial.availableForWrite ();
+  uint16_t n = this->tx_len - this->tx_pos;
+  if ((n==0)||(room<=0)) return 0;
+  if (n>(uint16_t)room) n = room;
+  Serial.write (this->tx + this->tx_pos, n);
+  this->tx_pos += n;
+  return 1;
+}
+
+void NorxProto::_run (norx_frame_t* f) {
+  Norx* x = this->norx;
+  uint8_t* out = this->tx + 5;
+  uint8_t* p = f->data;
+  uint16_t len = f->len, n = 0;
+  uint8_t st = NORX_PROTO_OK;
+  uint8_t bits = this->ctx.tmpl.bits;
+  uint8_t cmd = f->cmd;
+
+  // everything but INFO, KEY and WIPE needs a key, the data commands a
+  // message too
+  if ((cmd>=NORX_CMD_NONCE)&&(cmd<=NORX_CMD_VERIFY)&&!this->keyed) st = NORX_PROTO_ORDER;
+  if ((cmd>=NORX_CMD_HEADER)&&(cmd<=NORX_CMD_VERIFY)&&!this->started) st = NORX_PROTO_ORDER;
+
+  if (st==NORX_PROTO_OK) switch (cmd) {
+    case NORX_CMD_ERROR :
+      st = p[0];
+      break;
+    case NORX_CMD_INFO :
+      out[0] = NORX_PROTO_VERSION;
+      out[1] = NORX_MAX_BITS;
+      out[2] = NORX_MAX_LANES;
+      out[3] = NORX_PROTO_MAX & 0xff;
+      out[4] = NORX_PROTO_MAX >> 8;
+      n = 5;
+      break;
+    case NORX_CMD_KEY :
+      if (len<3) {
+        st = NORX_PROTO_LENGTH;
+        break;
+      }
+      bits = p[0];
+      if (((bits!=32)&&(bits!=NORX_MAX_BITS))||(p[1]<1)||(p[1]>63)||
+          (p[2]>NORX_MAX_LANES)||((p[2]==0)&&(NORX_MAX_LANES<2)))
+        st = NORX_PROTO_PARAM;
+      else if (len!=3 + (bits>>1))
+        st = NORX_PROTO_LENGTH;
+      else {
+        // the keyed start takes them from the context
+        x->rounds = p[1];
+        x->d = p[2];
+        x->prepare (&(this->ctx), bits, p + 3);
+        this->keyed = 1;
+        this->started = 0;
+      }
+      memset (p, 0, len);
+      break;
+    case NORX_CMD_NONCE :
+      if (len!=(bits>>2)) st = NORX_PROTO_LENGTH;
+      else {
+        x->start (&(this->ctx), p);
+        this->started = 1;
+      }
+      break;
+    case NORX_CMD_HEADER :
+      if (!x->header (p, len)) st = NORX_PROTO_ORDER;
+      break;
+    case NORX_CMD_ENCRYPT :
+      if (!x->encrypt (out, p, len)) st = NORX_PROTO_ORDER;
+      else n = len;
+      break;
+    case NORX_CMD_DECRYPT :
+      if (!x->decrypt (out, p, len)) st = NORX_PROTO_ORDER;
+      else n = len;
+      break;
+    case NORX_CMD_TRAILER :
+      if (!x->trailer (p, len)) st = NORX_PROTO_ORDER;
+      break;
+    case NORX_CMD_TAG :
+      x->tag (out);
+      n = x->tag_size ();
+      this->started = 0;
+      break;
+    case NORX_CMD_VERIFY :
+      if (len!=x->tag_size ()) st = NORX_PROTO_LENGTH;
+      else {
+        if (!x->verify (p)) st = NORX_PROTO_TAG;
+        this->started = 0;
+      }
+      break;
+    case NORX_CMD_WIPE :
+      // tag () is what wipes the state of a message under way
+      if (this->started) x->tag (out);
+      x->wipe (&(this->ctx));
+      this->keyed = 0;
+      this->started = 0;
+      break;
+    default :
+      st = NORX_PROTO_CMD;
+  }
+  if (st!=NORX_PROTO_OK) n = 0;
+  this->_reply ((cmd==NORX_CMD_ERROR) ? NORX_CMD_ERROR : (cmd | NORX_CMD_REPLY), st, n);
+}
+
+bool NorxProto::poll (void) {
+  norx_frame_t* other;
+  bool busy = this->_send ();
+
+  // take in what has arrived, until both buffers hold a frame
+  while ((this->rx_state!=RX_FULL)&&(Serial.available ()>0)) {
+    busy = 1;
+    if (!this->_receive ((uint8_t)Serial.read ())) continue;
+    if (this->ready) this->rx_state = RX_FULL;
+    else {
+      this->ready = this->rx;
+      this->rx = (this->rx==&(this->frames[0])) ? &(this->frames[1]) : &(this->frames[0]);
+    }
+  }
+
+  // one frame, once the previous reply is out of the way
+  if (this->ready && (this->tx_pos==this->tx_len)) {
+    other = this->ready;
+    this->ready = NULL;
+    this->_run (other);
+    if (this->rx_state==RX_FULL) {
+      this->ready = this->rx;
+      this->rx = other;
+      this->rx_state = RX_HUNT;
+    }
+    this->_send ();
+    busy = 1;
+  }
+  return busy;
+}
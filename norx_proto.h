@@ -0,0 +1,114 @@
+#ifndef __norx_proto_h_
+#define __norx_proto_h_
+
+#include "norx.h"
+
+/***************************************************************************
+ * framed serial protocol, the board as an AEAD coprocessor
+ *
+ * a frame is
+ *   0x7e  cmd  len (2 bytes)  payload (len bytes)  crc (4 bytes)
+ * with len and crc little endian, the CRC-32 (cryptoutils.h) of cmd, len
+ * and payload. a reply carries cmd | 0x80 and a payload starting with a
+ * NORX_PROTO_* status, followed by the data, if any. the commands :
+ *
+ *   INFO     -                      version, NORX_MAX_BITS, NORX_MAX_LANES
+ *                                   and NORX_PROTO_MAX (2 bytes)
+ *   KEY      bits rounds d key      keys the board, key is bits/2 bytes
+ *   NONCE    nonce                  starts a message, bits/4 bytes
+ *   HEADER   chunk                  -
+ *   ENCRYPT  chunk                  the ciphertext of chunk
+ *   DECRYPT  chunk                  the plaintext of chunk
+ *   TRAILER  chunk                  -
+ *   TAG      -                      the tag, ends the message
+ *   VERIFY   tag                    OK or TAG, ends the message
+ *   WIPE     -                      forgets the key and the message
+ *
+ * the data commands follow Norx's streaming API, any number of chunks of
+ * any size up to NORX_PROTO_MAX, phases in order. as with Norx::decrypt
+ * the plaintext goes out before the tag is checked, it must be held back
+ * by the host until VERIFY says OK.
+ *
+ * poll () never waits : it sends what the UART will take of the pending
+ * reply, moves the bytes received so far through the frame parser, and
+ * runs at most one complete frame. there are two frame buffers, so the
+ * next frame is received (by the UART interrupt, then by the parser)
+ * while the previous one is being run; a third frame stays in the UART
+ * until one is free. noise before a frame is skipped. a frame with a bad
+ * CRC or too long is answered with cmd 0xff and the parser looks for the
+ * next 0x7e, it is up to the host to resend.
+ */
+
+#define NORX_PROTO_VERSION  1
+#define NORX_PROTO_SOF      0x7e
+#define NORX_PROTO_BAUD     115200   // the sketch's, norxclient's default
+
+#ifndef NORX_PROTO_MAX
+#if defined(ARDUINO_HOST)
+#define NORX_PROTO_MAX      1024
+#else
+#define NORX_PROTO_MAX      64
+#endif
+#endif
+
+#define NORX_CMD_INFO       0x00
+#define NORX_CMD_KEY        0x01
+#define NORX_CMD_NONCE      0x02
+#define NORX_CMD_HEADER     0x03
+#define NORX_CMD_ENCRYPT    0x04
+#define NORX_CMD_DECRYPT    0x05
+#define NORX_CMD_TRAILER    0x06
+#define NORX_CMD_TAG        0x07
+#define NORX_CMD_VERIFY     0x08
+#define NORX_CMD_WIPE       0x09
+#define NORX_CMD_REPLY      0x80
+#define NORX_CMD_ERROR      0xff
+
+#define NORX_PROTO_OK       0
+#define NORX_PROTO_CRC      1   // bad CRC, the frame was dropped
+#define NORX_PROTO_LENGTH   2   // too long, or wrong for the command
+#define NORX_PROTO_CMD      3   // unknown command
+#define NORX_PROTO_ORDER    4   // no key, no message, or phase gone by
+#define NORX_PROTO_PARAM    5   // bits, rounds or d not supported
+#define NORX_PROTO_TAG      6   // VERIFY, the tag does not match
+
+typedef struct {
+  uint8_t  cmd;
+  uint16_t len;
+  uint8_t  data[NORX_PROTO_MAX];
+} norx_frame_t;
+
+class NorxProto {
+  private :
+    Norx* norx;
+    norx_key_t ctx;
+    bool keyed;
+    bool started;
+
+    // parser : state, bytes of len or crc seen, the frame being received
+    uint8_t rx_state;
+    uint8_t rx_n;
+    uint16_t rx_pos;
+    uint32_t rx_crc;
+    norx_frame_t* rx;
+    // the frame waiting to be run, if any
+    norx_frame_t* ready;
+    norx_frame_t frames[2];
+
+    // the reply : 0x7e, cmd, len, status, data, crc
+    uint8_t tx[5 + NORX_PROTO_MAX + 4];
+    uint16_t tx_len;
+    uint16_t tx_pos;
+
+    bool _receive (uint8_t c);
+    void _run (norx_frame_t* f);
+    void _reply (uint8_t cmd, uint8_t status, uint16_t len);
+    bool _send (void);
+
+  public :
+    NorxProto (Norx* norx);
+    // true if anything was done, poll again at once then
+    bool poll (void);
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "norx_simd.h"
+
+#if NORX_SIMD
+
+#include <immintrin.h>
+
+typedef void (*norx_simd_32_t) (uint32_t* x, uint8_t r);
+typedef void (*norx_simd_64_t) (uint64_t* x, uint8_t r);
+
+/***************************************************************************
+ * NORX32, SSE2
+ */
+
+#define SSE2_H(a, b) \
+  _mm_xor_si128 (_mm_xor_si128 ((a), (b)), \
+                 _mm_add_epi32 (_mm_and_si128 ((a), (b)), _mm_and_si128 ((a), (b))))
+#define SSE2_ROR(x, n) \
+  _mm_or_si128 (_mm_srli_epi32 ((x), (n)), _mm_slli_epi32 ((x), 32 - (n)))
+#define SSE2_ROR16(x) \
+  _mm_shufflehi_epi16 (_mm_shufflelo_epi16 ((x), _MM_SHUFFLE (2, 3, 0, 1)), _MM_SHUFFLE (2, 3, 0, 1))
+
+#define SSE2_G(a, b, c, d) \
+  a = SSE2_H (a, b); d = SSE2_ROR (_mm_xor_si128 (a, d), 8); \
+  c = SSE2_H (c, d); b = SSE2_ROR (_mm_xor_si128 (b, c), 11); \
+  a = SSE2_H (a, b); d = SSE2_ROR16 (_mm_xor_si128 (a, d)); \
+  c = SSE2_H (c, d); b = SSE2_ROR (_mm_xor_si128 (b, c), 31);
+
+__attribute__ ((target ("sse2")))
+static void _permute_32_sse2 (uint32_t* x, uint8_t r) {
+  __m128i r0 = _mm_loadu_si128 ((__m128i*)(x));
+  __m128i r1 = _mm_loadu_si128 ((__m128i*)(x + 4));
+  __m128i r2 = _mm_loadu_si128 ((__m128i*)(x + 8));
+  __m128i r3 = _mm_loadu_si128 ((__m128i*)(x + 12));
+
+  while (r--) {
+    // columns
+    SSE2_G (r0, r1, r2, r3);
+    // diagonalize
+    r1 = _mm_shuffle_epi32 (r1, _MM_SHUFFLE (0, 3, 2, 1));
+    r2 = _mm_shuffle_epi32 (r2, _MM_SHUFFLE (1, 0, 3, 2));
+    r3 = _mm_shuffle_epi32 (r3, _MM_SHUFFLE (2, 1, 0, 3));
+    // diagonals
+    SSE2_G (r0, r1, r2, r3);
+    // undiagonalize
+    r1 = _mm_shuffle_epi32 (r1, _MM_SHUFFLE (2, 1, 0, 3));
+    r2 = _mm_shuffle_epi32 (r2, _MM_SHUFFLE (1, 0, 3, 2));
+    r3 = _mm_shuffle_epi32 (r3, _MM_SHUFFLE (0, 3, 2, 1));
+  }
+
+  _mm_storeu_si128 ((__m128i*)(x), r0);
+  _mm_storeu_si128 ((__m128i*)(x + 4), r1);
+  _mm_storeu_si128 ((__m128i*)(x + 8), r2);
+  _mm_storeu_si128 ((__m128i*)(x + 12), r3);
+}
+
+/***************************************************************************
+ * NORX64, AVX2. ROR 8 and 40 are byte shuffles
+ */
+
+#define AVX2_H(a, b) \
+  _mm256_xor_si256 (_mm256_xor_si256 ((a), (b)), \
+                    _mm256_add_epi64 (_mm256_and_si256 ((a), (b)), _mm256_and_si256 ((a), (b))))
+#define AVX2_ROR(x, n) \
+  _mm256_or_si256 (_mm256_srli_epi64 ((x), (n)), _mm256_slli_epi64 ((x), 64 - (n)))
+#define AVX2_ROR63(x) \
+  _mm256_or_si256 (_mm256_srli_epi64 ((x), 63), _mm256_add_epi64 ((x), (x)))
+
+#define AVX2_G(a, b, c, d) \
+  a = AVX2_H (a, b); d = _mm256_shuffle_epi8 (_mm256_xor_si256 (a, d), ror8); \
+  c = AVX2_H (c, d); b = AVX2_ROR (_mm256_xor_si256 (b, c), 19); \
+  a = AVX2_H (a, b); d = _mm256_shuffle_epi8 (_mm256_xor_si256 (a, d), ror40); \
+  c = AVX2_H (c, d); b = AVX2_ROR63 (_mm256_xor_si256 (b, c));
+
+__attribute__ ((target ("avx2")))
+static void _permute_64_avx2 (uint64_t* x, uint8_t r) {
+  const __m256i ror8 = _mm256_setr_epi8 (
+    1, 2, 3, 4, 5, 6, 7, 0, 9, 10, 11, 12, 13, 14, 15, 8,
+    1, 2, 3, 4, 5, 6, 7, 0, 9, 10, 11, 12, 13, 14, 15, 8);
+  const __m256i ror40 = _mm256_setr_epi8 (
+    5, 6, 7, 0, 1, 2, 3, 4, 13, 14, 15, 8, 9, 10, 11, 12,
+    5, 6, 7, 0, 1, 2, 3, 4, 13, 14, 15, 8, 9, 10, 11, 12);
+  __m256i r0 = _mm256_loadu_si256 ((__m256i*)(x));
+  __m256i r1 = _mm256_loadu_si256 ((__m256i*)(x + 4));
+  __m256i r2 = _mm256_loadu_si256 ((__m256i*)(x + 8));
+  __m256i r3 = _mm256_loadu_si256 ((__m256i*)(x + 12));
+
+  while (r--) {
+    // columns
+    AVX2_G (r0, r1, r2, r3);
+    // diagonalize
+    r1 = _mm256_permute4x64_epi64 (r1, _MM_SHUFFLE (0, 3, 2, 1));
+    r2 = _mm256_permute4x64_epi64 (r2, _MM_SHUFFLE (1, 0, 3, 2));
+    r3 = _mm256_permute4x64_epi64 (r3, _MM_SHUFFLE (2, 1, 0, 3));
+    // diagonals
+    AVX2_G (r0, r1, r2, r3);
+    // undiagonalize
+    r1 = _mm256_permute4x64_epi64 (r1, _MM_SHUFFLE (2, 1, 0, 3));
+    r2 = _mm256_permute4x64_epi64 (r2, _MM_SHUFFLE (1, 0, 3, 2));
+    r3 = _mm256_permute4x64_epi64 (r3, _MM_SHUFFLE (0, 3, 2, 1));
+  }
+
+  _mm256_storeu_si256 ((__m256i*)(x), r0);
+  _mm256_storeu_si256 ((__m256i*)(x + 4), r1);
+  _mm256_storeu_si256 ((__m256i*)(x + 8), r2);
+  _mm256_storeu_si256 ((__m256i*)(x + 12), r3);
+}
+
+/***************************************************************************
+ * runtime selection
+ */
+
+static norx_simd_32_t _select_32 (void) {
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("sse2")) return _permute_32_sse2;
+  return NULL;
+}
+
+static norx_simd_64_t _select_64 (void) {
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2")) return _permute_64_avx2;
+  return NULL;
+}
+
+static norx_simd_32_t _simd_32 = _select_32 ();
+static norx_simd_64_t _simd_64 = _select_64 ();
+
+const char* norx_simd_name (uint8_t bits) {
+  if ((bits==32)&&_simd_32) return "sse2";
+  if ((bits==64)&&_simd_64) return "avx2";
+  return "scalar";
+}
+
+bool norx_simd_permute (state_t* s, uint8_t r) {
+  if ((s->bits==32)&&_simd_32) {
+    _simd_32 (s->s32.w, r);
+    return 1;
+  }
+#if NORX_64
+  if ((s->bits==64)&&_simd_64) {
+    _simd_64 (s->s64.w, r);
+    return 1;
+  }
+#endif
+  return 0;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef __norx_simd_h_
+#define __norx_simd_h_
+
+#include "norx.h"
+
+/***************************************************************************
+ * vectorized F^R for x86 hosts
+ *
+ * each row of the state sits in one vector register, so the four column
+ * Gs run as one, then the rows are rotated by 1, 2 and 3 lanes so that the
+ * diagonals line up as columns, and rotated back :
+ *   NORX32 with SSE2, one 128 bit register per row
+ *   NORX64 with AVX2, one 256 bit register per row
+ * the instruction set is checked once with CPUID, norx_simd_permute returns
+ * 0 when there is no vector unit for that width and the caller falls back
+ * to the scalar core. NORX_SIMD=0 leaves only the scalar core.
+ */
+
+#ifndef NORX_SIMD
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define NORX_SIMD 1
+#else
+#define NORX_SIMD 0
+#endif
+#endif
+
+#if NORX_SIMD
+bool norx_simd_permute (state_t* s, uint8_t r);
+const char* norx_simd_name (uint8_t bits);
+#endif
+
+#endif
@@ -0,0 +1,77 @@
+#include "norx_stack.h"
+
+#if defined(__AVR__)
+
+#include <avr/io.h>
+
+extern uint8_t __data_start;
+extern uint8_t __heap_start;
+extern uint8_t* __brkval;
+
+size_t norx_stack_measure (norx_stack_fn_t fn, void* arg) {
+  uint8_t* top = (uint8_t*)SP;
+  uint8_t* p = __brkval ? __brkval : &__heap_start;
+  uint8_t* bottom = p;
+
+  // below the stack pointer nothing is in use
+  while (p < top) *p++ = NORX_STACK_PAINT;
+  fn (arg);
+  for (p=bottom;(p<top)&&(*p==NORX_STACK_PAINT);p++);
+  return top - p;
+}
+
+size_t norx_stack_static (void) {
+  return &__heap_start - &__data_start;
+}
+
+#elif defined(ARDUINO_HOST) && defined(__linux__)
+
+#include <ucontext.h>
+
+static ucontext_t caller, callee;
+static norx_stack_fn_t run_fn;
+static void* run_arg;
+
+static void norx_stack_run (void) {
+  run_fn (run_arg);
+}
+
+size_t norx_stack_measure (norx_stack_fn_t fn, void* arg) {
+  uint8_t* stack = (uint8_t*)malloc (NORX_STACK_HOST);
+  uint8_t* p;
+  size_t used;
+
+  if (!stack) return 0;
+  memset (stack, NORX_STACK_PAINT, NORX_STACK_HOST);
+  run_fn = fn;
+  run_arg = arg;
+  getcontext (&callee);
+  callee.uc_stack.ss_sp = stack;
+  callee.uc_stack.ss_size = NORX_STACK_HOST;
+  callee.uc_link = &caller;
+  makecontext (&callee, norx_stack_run, 0);
+  swapcontext (&caller, &callee);
+
+  // the stack grows down, from stack + NORX_STACK_HOST
+  for (p=stack;(p<stack+NORX_STACK_HOST)&&(*p==NORX_STACK_PAINT);p++);
+  used = stack + NORX_STACK_HOST - p;
+  free (stack);
+  return used;
+}
+
+size_t norx_stack_static (void) {
+  return 0;
+}
+
+#else
+
+size_t norx_stack_measure (norx_stack_fn_t fn, void* arg) {
+  fn (arg);
+  return 0;
+}
+
+size_t norx_stack_static (void) {
+  return 0;
+}
+
+#endif
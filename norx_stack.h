@@ -0,0 +1,32 @@
+#ifndef __norx_stack_h_
+#define __norx_stack_h_
+
+#include "Arduino.h"
+
+/***************************************************************************
+ * stack high water mark, by stack painting
+ *
+ * norx_stack_measure runs fn (arg) and returns the most stack it used, in
+ * bytes. on AVR the free SRAM between the heap and the stack pointer is
+ * filled with NORX_STACK_PAINT beforehand, and the deepest byte no longer
+ * holding it gives the peak; interrupts that fire meanwhile are counted
+ * in. on the host fn runs on a painted stack of its own, NORX_STACK_HOST
+ * bytes (ucontext), and the numbers are those of the host's code, not of
+ * the board's. elsewhere nothing is measured and 0 is returned.
+ *
+ * norx_stack_static returns the static RAM (.data and .bss) on AVR, 0
+ * elsewhere
+ */
+
+#define NORX_STACK_PAINT 0xc5
+
+#ifndef NORX_STACK_HOST
+#define NORX_STACK_HOST  262144
+#endif
+
+typedef void (*norx_stack_fn_t) (void* arg);
+
+size_t norx_stack_measure (norx_stack_fn_t fn, void* arg);
+size_t norx_stack_static (void);
+
+#endif
@@ -0,0 +1,104 @@
+#include "norx.h"
+
+#if NORX_STATS
+
+#if defined(__AVR__)
+#include <avr/io.h>
+#elif defined(ARDUINO_HOST)
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+/***************************************************************************
+ * probes, see norx_stats.h
+ *
+ * sections nest (F^R within a phase, a phase within nothing). the window
+ * is painted below each section as it begins, after the deepest byte the
+ * enclosing one reached so far has been folded into low; the enclosing
+ * section then carries on from the deeper of its own and the inner's. the
+ * cycles spent in here are subtracted from the enclosing sections
+ */
+
+#if defined(__AVR__)
+extern uint8_t __heap_start;
+extern uint8_t* __brkval;
+#endif
+
+static uint8_t* bottom;    // of the window, set by the outermost
+static uint8_t* low;       // deepest byte reached, for the open section
+static uint8_t depth;
+static uint32_t spent;
+
+static uint32_t norx_cycles (void) {
+#if defined(ARDUINO_HOST)
+#if defined(__x86_64__) || defined(__i386__)
+  return (uint32_t)__rdtsc ();
+#else
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000000UL + ts.tv_nsec);
+#endif
+#else
+  return micros () * clockCyclesPerMicrosecond ();
+#endif
+}
+
+/* the lowest byte below top that no longer holds the paint, or top */
+static uint8_t* norx_deepest (uint8_t* top) {
+  uint8_t* q;
+  for (q=bottom;(q<top)&&(*q==NORX_STATS_PAINT);q++);
+  return q;
+}
+
+void norx_probe_begin (norx_probe_t* p) {
+  uint32_t t = norx_cycles ();
+  uint8_t *sp, *top, *q;
+
+#if defined(__AVR__)
+  sp = (uint8_t*)SP;
+#else
+  sp = (uint8_t*)__builtin_frame_address (0);
+#endif
+  top = sp - NORX_STATS_SKIP;
+  if (depth) {
+    q = norx_deepest (top);
+    if (q < low) low = q;
+  } else {
+    bottom = top - NORX_STATS_WINDOW;
+#if defined(__AVR__)
+    q = __brkval ? __brkval : &__heap_start;
+    if ((uintptr_t)top < (uintptr_t)q + NORX_STATS_WINDOW) bottom = q;
+#endif
+    low = top;
+  }
+  p->low = low;
+  for (q=bottom;q<top;q++) *(volatile uint8_t*)q = NORX_STATS_PAINT;
+  low = top;
+  p->sp = sp;
+  depth++;
+
+  p->start = norx_cycles ();
+  spent += p->start - t;
+  p->skew = spent;
+}
+
+void norx_probe_end (norx_probe_t* p, norx_stat_t* st) {
+  uint32_t t = norx_cycles ();
+  uint32_t c = t - p->start - (spent - p->skew);
+  uint8_t* q = norx_deepest (p->sp - NORX_STATS_SKIP);
+  uint16_t used;
+
+  if (q < low) low = q;
+  used = p->sp - low;
+  st->calls++;
+  st->cycles += c;
+  if (c > st->max) st->max = c;
+  if (used > st->stack) st->stack = used;
+  if (p->low < low) low = p->low;
+  depth--;
+  spent += norx_cycles () - t;
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef __norx_stats_h_
+#define __norx_stats_h_
+
+/***************************************************************************
+ * compile-time cycle and stack instrumentation
+ *
+ * with NORX_STATS=1 every instance keeps a norx_stats_t, read with
+ * Norx::stats and cleared with Norx::stats_reset. it holds, for init, each
+ * data phase, the finalization and every F^R (NORX_STAT_*) :
+ *   calls    the number of probed sections
+ *   cycles   their total, and max the longest one
+ *   stack    the deepest stack any of them reached, in bytes below the
+ *            point where the section was entered
+ * a data phase is probed in each update call and once more when it is
+ * closed (padding, last block, merge of the lanes). F^R sections are also
+ * counted within the phase around them.
+ *
+ * cycles come from micros () on AVR (Timer0, 4us or 64 cycles at 16MHz),
+ * from the time stamp counter on x86 hosts and from clock_gettime (ns)
+ * elsewhere. the stack is found by painting the free stack below each
+ * section with NORX_STATS_PAINT and looking for the deepest byte no longer
+ * holding it, like norx_stack.h does; on x86-64 hosts the probe's own frame
+ * and the red zone below it are left alone, so a section reaches at least
+ * NORX_STATS_SKIP bytes. the painting is not counted in the cycles, but it
+ * does slow things down.
+ *
+ * the bookkeeping is global, not per instance : an instrumented build is
+ * meant for one thread, and the payload thread pool (norx_pool.h) is not
+ * used by it. with NORX_STATS=0, the default, the probes compile to
+ * nothing and Norx has no stats member. on the host, make STATS=1. included
+ * by norx.h
+ */
+
+#ifndef NORX_STATS
+#define NORX_STATS 0
+#endif
+
+#define NORX_STAT_INIT    0
+#define NORX_STAT_HEADER  1
+#define NORX_STAT_PAYLOAD 2
+#define NORX_STAT_TRAILER 3
+#define NORX_STAT_FINAL   4
+#define NORX_STAT_F       5
+#define NORX_STAT_COUNT   6
+
+// index of the phase with domain tag t (NORX_TAG_HEADER..NORX_TAG_FINAL)
+#define NORX_STAT_PHASE(t) (((t)==0x01) ? NORX_STAT_HEADER : ((t)==0x02) ? NORX_STAT_PAYLOAD : \
+                            ((t)==0x04) ? NORX_STAT_TRAILER : NORX_STAT_FINAL)
+
+#define NORX_STATS_PAINT 0x5c
+
+// bytes painted below a section, and left alone at the top
+#ifndef NORX_STATS_WINDOW
+#if defined(ARDUINO_HOST)
+#define NORX_STATS_WINDOW 4096
+#else
+#define NORX_STATS_WINDOW 768
+#endif
+#endif
+
+#if defined(ARDUINO_HOST) && defined(__x86_64__)
+#define NORX_STATS_SKIP   256
+#else
+#define NORX_STATS_SKIP   0
+#endif
+
+typedef struct {
+  uint32_t calls;
+  uint32_t cycles;
+  uint32_t max;
+  uint16_t stack;
+} norx_stat_t;
+
+typedef struct {
+  norx_stat_t s[NORX_STAT_COUNT];
+  uint32_t rounds;   // F applied, over all F^R
+} norx_stats_t;
+
+// a section being measured
+typedef struct {
+  uint8_t* sp;
+  uint8_t* low;
+  uint32_t start;
+  uint32_t skew;
+} norx_probe_t;
+
+#if NORX_STATS
+void norx_probe_begin (norx_probe_t* p);
+void norx_probe_end (norx_probe_t* p, norx_stat_t* st);
+
+#define NORX_PROBE_BEGIN(p) norx_probe_t p; norx_probe_begin (&(p))
+#define NORX_PROBE_END(p, i) norx_probe_end (&(p), &(this->stat.s[i]))
+#define NORX_STAT_ROUNDS(r) this->stat.rounds += (r)
+#else
+#define NORX_PROBE_BEGIN(p)
+#define NORX_PROBE_END(p, i)
+#define NORX_STAT_ROUNDS(r)
+#endif
+
+#endif
@@ -0,0 +1,468 @@
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "norx_step.h"
+#include "norx_core.h"
+#include "norx_ct.h"
+#include "cryptoutils.h"
+
+// stages of an operation, each runs until it queues an F^R or is done
+#define STEP_IDLE         0
+#define STEP_INIT         1   // after the init F^R
+#define STEP_PHASE        2   // closing the phase before p, if it was used
+#define STEP_PAD          3
+#define STEP_MERGE        4   // parallel payload, lane i closed
+#define STEP_MERGED       5
+#define STEP_MERGE_END    6
+#define STEP_CLOSE        7
+#define STEP_DATA         8   // in goes through the rate of p
+#define STEP_OPEN         9   // a block is opened, then back to ret
+#define STEP_BRANCHED     10
+#define STEP_LANE         11
+#define STEP_LANE_MERGED  12
+#define STEP_LANE_COPY    13
+#define STEP_INJECT       14
+#define STEP_OPENED       15
+#define STEP_FINAL        16
+#define STEP_FINAL2       17
+#define STEP_TAG          18
+
+#if NORX_TRACE_LEVEL >= NORX_TRACE_SUMMARY
+#define STEP_TRACE(s, label) this->x->_trace ((s), (char*)(label))
+#else
+#define STEP_TRACE(s, label)
+#endif
+
+// the words of the eight G of a round, columns then diagonals
+const uint8_t STEP_G[8][4] PROGMEM = {
+  { 0, 4,  8, 12 }, { 1, 5,  9, 13 }, { 2, 6, 10, 14 }, { 3, 7, 11, 15 },
+  { 0, 5, 10, 15 }, { 1, 6, 11, 12 }, { 2, 7,  8, 13 }, { 3, 4,  9, 14 }
+};
+
+NorxStep::NorxStep (Norx* norx) {
+  this->x = norx;
+  this->r = 0;
+  this->g = 0;
+  this->stage = STEP_IDLE;
+  this->result = 0;
+  this->quantum = NORX_STEP_QUANTUM;
+}
+
+/***************************************************************************
+ * the sliced permutation
+ */
+
+/* queues F^R on s, the operation goes on at stage next */
+void NorxStep::_permute (state_t* s, uint8_t next) {
+  this->s = s;
+  this->r = this->x->rounds;
+  this->g = 0;
+  this->stage = next;
+}
+
+void NorxStep::_G (void) {
+  const uint8_t* w = STEP_G[this->g];
+  this->x->_G (this->s, pgm_read_byte (w), pgm_read_byte (w + 1),
+               pgm_read_byte (w + 2), pgm_read_byte (w + 3));
+}
+
+void NorxStep::_round (void) {
+#if NORX_SMALL
+  if (this->s->bits==8) Norx8F::round (this->s->s8.w);
+  if (this->s->bits==16) Norx16F::round (this->s->s16.w);
+#endif
+  if (this->s->bits==32) Norx32F::round (this->s->s32.w);
+#if NORX_64
+  if (this->s->bits==64) Norx64F::round (this->s->s64.w);
+#endif
+}
+
+bool NorxStep::step (uint16_t n) {
+  for (;;) {
+    if (!this->r) {
+      if (this->stage==STEP_IDLE) return 0;
+      if ((this->stage==STEP_DATA)&&(n>=8*this->x->rounds)&&this->_block ()) {
+        n -= 8*this->x->rounds;
+        continue;
+      }
+      this->_advance ();
+      continue;
+    }
+    if (!n) return 1;
+    if (!this->g && (n>=8*this->r)) {
+      n -= 8*this->r;
+      this->x->_permute (this->s, this->r);
+      this->r = 0;
+    } else if (!this->g && (n>=8)) {
+      n -= 8;
+      this->_round ();
+      this->r--;
+    } else {
+      n--;
+      this->_G ();
+      if (++this->g==8) {
+        this->g = 0;
+        this->r--;
+      }
+    }
+  }
+}
+
+/* a whole block with its F^R, as _duplex does it, when there is room for
+   one and no lane to branch or merge. false if the stages must do it */
+bool NorxStep::_block (void) {
+  Norx* x = this->x;
+  uint8_t rate = x->_rate (&(x->state));
+  if ((x->pos!=rate)||(this->len<rate)) return 0;
+  if ((x->phase==NORX_TAG_PAYLOAD)&&x->_parallel ()) {
+    if (!x->d||!x->blk) return 0;
+    x->cur = &(x->lane[x->blk % x->d]);
+    x->blk++;
+  }
+  x->_inject (x->cur, x->phase);
+  x->_permute (x->cur, x->rounds);
+  x->_rate_block (x->cur, this->out, this->in, this->mode);
+  x->used = 1;
+  this->in += rate;
+  if (this->mode!=NORX_MODE_ABSORB) this->out += rate;
+  this->len -= rate;
+  return 1;
+}
+
+bool NorxStep::run (uint16_t us) {
+  unsigned long t0 = micros (), t = t0, u;
+  bool more;
+  for (;;) {
+    more = this->step (this->quantum);
+    u = micros ();
+    if ((u - t)*4>us) {
+      if (this->quantum>1) this->quantum >>= 1;
+    } else if (((u - t)*8<us)&&(this->quantum<NORX_STEP_QUANTUM_MAX)) {
+      this->quantum <<= 1;
+    }
+    if (!more||(u - t0>=us)) return more;
+    t = u;
+  }
+}
+
+bool NorxStep::busy (void) {
+  return this->stage!=STEP_IDLE;
+}
+
+bool NorxStep::ok (void) {
+  return this->result;
+}
+
+/***************************************************************************
+ * the operations, Norx's streaming AEAD cut at every F^R. the stages
+ * follow _phase, _end_phase, _merge_lanes, _next_block, _next_lane and tag
+ */
+
+void NorxStep::_advance (void) {
+  Norx* x = this->x;
+  uint8_t rate = x->_rate (&(x->state));
+  uint8_t i, d;
+  size_t n;
+
+  switch (this->stage) {
+    case STEP_INIT :
+      STEP_TRACE (&(x->state), "init  ");
+      x->_start ();
+      this->stage = STEP_IDLE;
+      return;
+
+    case STEP_PHASE :
+      if (x->phase==this->p) {
+        this->stage = STEP_DATA;
+      } else if (!x->used) {
+        this->stage = STEP_CLOSE;
+      } else if (x->pos==rate) {
+        this->ret = STEP_PAD;
+        this->stage = STEP_OPEN;
+      } else {
+        this->stage = STEP_PAD;
+      }
+      return;
+    case STEP_PAD :
+      x->_pad ();
+      this->i = 0;
+      this->stage = STEP_CLOSE;
+      if ((x->phase==NORX_TAG_PAYLOAD)&&(x->blk)) {
+        if (x->d) x->empty_state (x->state.bits, &(x->state));
+        this->stage = STEP_MERGE;
+      }
+      return;
+    case STEP_MERGE :
+      if (x->d ? (this->i<x->d) : (x->open && !this->i)) {
+        x->_inject (&(x->lane[this->i]), NORX_TAG_MERGE);
+        this->_permute (&(x->lane[this->i]), STEP_MERGED);
+      } else {
+        this->stage = STEP_MERGE_END;
+      }
+      return;
+    case STEP_MERGED :
+      x->_fold (&(x->lane[this->i]), x->d ? &(x->state) : &(x->lane[1]));
+      this->i++;
+      this->stage = STEP_MERGE;
+      return;
+    case STEP_MERGE_END :
+      if (!x->d) x->copy_state (&(x->lane[1]), &(x->state));
+      memset (x->lane, 0, sizeof(x->lane));
+      x->cur = &(x->state);
+      x->open = 0;
+      x->blk = 0;
+      this->stage = STEP_CLOSE;
+      return;
+    case STEP_CLOSE :
+      if (x->used) {
+        if (x->phase==NORX_TAG_HEADER) STEP_TRACE (&(x->state), "header");
+        if (x->phase==NORX_TAG_PAYLOAD) STEP_TRACE (&(x->state), "payld ");
+        if (x->phase==NORX_TAG_TRAILER) STEP_TRACE (&(x->state), "trail ");
+      }
+      x->phase = this->p;
+      x->pos = rate;
+      x->used = 0;
+      this->stage = (this->p==NORX_TAG_FINAL) ? STEP_FINAL : STEP_DATA;
+      return;
+
+    // at most one block per stage, whole ones word by word
+    case STEP_DATA :
+      if (!this->len) {
+        this->stage = STEP_IDLE;
+        return;
+      }
+      if (x->pos==rate) {
+        this->ret = STEP_DATA;
+        this->stage = STEP_OPEN;
+        return;
+      }
+      if (!x->pos && (this->len>=rate)) {
+        x->_rate_block (x->cur, this->out, this->in, this->mode);
+        x->pos = rate;
+        x->used = 1;
+        n = rate;
+      } else {
+        n = min (this->len, (size_t)(rate - x->pos));
+        x->_duplex (this->out, this->in, n, this->mode);
+      }
+      this->in += n;
+      if (this->mode!=NORX_MODE_ABSORB) this->out += n;
+      this->len -= n;
+      return;
+
+    case STEP_OPEN :
+      this->stage = STEP_INJECT;
+      if ((x->phase==NORX_TAG_PAYLOAD)&&x->_parallel ()) {
+        this->stage = STEP_LANE;
+        if (!x->blk) {
+          x->_inject (&(x->state), NORX_TAG_BRANCH);
+          this->_permute (&(x->state), STEP_BRANCHED);
+        }
+      }
+      return;
+    case STEP_BRANCHED :
+      x->_fork ();
+      this->stage = STEP_LANE;
+      return;
+    case STEP_LANE :
+      d = x->d;
+      if (d) {
+        x->cur = &(x->lane[x->blk % d]);
+        x->blk++;
+        this->stage = STEP_INJECT;
+      } else if (x->open) {
+        x->_inject (&(x->lane[0]), NORX_TAG_MERGE);
+        this->_permute (&(x->lane[0]), STEP_LANE_MERGED);
+      } else {
+        this->stage = STEP_LANE_COPY;
+      }
+      return;
+    case STEP_LANE_MERGED :
+      x->_fold (&(x->lane[0]), &(x->lane[1]));
+      this->stage = STEP_LANE_COPY;
+      return;
+    case STEP_LANE_COPY :
+      x->copy_state (&(x->state), &(x->lane[0]));
+      x->_lane_id (&(x->lane[0]), x->blk);
+      x->cur = &(x->lane[0]);
+      x->open = 1;
+      x->blk++;
+      this->stage = STEP_INJECT;
+      return;
+    case STEP_INJECT :
+      x->_inject (x->cur, x->phase);
+      this->_permute (x->cur, STEP_OPENED);
+      return;
+    case STEP_OPENED :
+      x->pos = 0;
+      this->stage = this->ret;
+      return;
+
+    case STEP_FINAL :
+      x->_inject (&(x->state), NORX_TAG_FINAL);
+      this->_permute (&(x->state), STEP_FINAL2);
+      return;
+    case STEP_FINAL2 :
+      this->_permute (&(x->state), STEP_TAG);
+      return;
+    case STEP_TAG :
+      STEP_TRACE (&(x->state), "final ");
+      if (this->expect) {
+        // constant time, as Norx::verify
+        d = 0;
+        for (i=0;i<x->tag_size ();i++)
+          d |= *(x->_rate_byte (&(x->state), i)) ^ this->expect[i];
+        d = (1 & ((d - 1) >> 8));
+        NORX_CT_PUBLIC (&d, 1);
+        this->result = d;
+      } else {
+        for (i=0;i<x->tag_size ();i++)
+          this->out[i] = *(x->_rate_byte (&(x->state), i));
+      }
+      x->empty_state (x->state.bits, &(x->state));
+      this->stage = STEP_IDLE;
+      return;
+  }
+}
+
+/* queues the key and nonce setup's F^R, the setup itself is done here */
+bool NorxStep::start (uint8_t bits, const uint8_t* key, const uint8_t* nonce) {
+  Norx* x = this->x;
+  if (this->busy ()||!x->_load (&(x->state), bits, key, nonce)) return 0;
+  this->_permute (&(x->state), STEP_INIT);
+  return 1;
+}
+
+bool NorxStep::start (const norx_key_t* ctx, const uint8_t* nonce) {
+  Norx* x = this->x;
+  if (this->busy ()) return 0;
+  x->rounds = ctx->tmpl.rounds;
+  x->d = ctx->d;
+  x->state = ctx->tmpl;
+  x->_nonce (&(x->state), nonce);
+  this->_permute (&(x->state), STEP_INIT);
+  return 1;
+}
+
+bool NorxStep::_data (uint8_t p, uint8_t* out, const uint8_t* in, size_t len, uint8_t mode) {
+  if (this->busy ()||(this->x->phase>p)) return 0;
+  this->p = p;
+  this->out = out;
+  this->in = in;
+  this->len = len;
+  this->mode = mode;
+  this->stage = STEP_PHASE;
+  return 1;
+}
+
+bool NorxStep::header (const uint8_t* h, size_t len) {
+  return this->_data (NORX_TAG_HEADER, NULL, h, len, NORX_MODE_ABSORB);
+}
+
+bool NorxStep::encrypt (uint8_t* c, const uint8_t* m, size_t len) {
+  return this->_data (NORX_TAG_PAYLOAD, c, m, len, NORX_MODE_ENCRYPT);
+}
+
+bool NorxStep::decrypt (uint8_t* m, const uint8_t* c, size_t len) {
+  return this->_data (NORX_TAG_PAYLOAD, m, c, len, NORX_MODE_DECRYPT);
+}
+
+bool NorxStep::trailer (const uint8_t* t, size_t len) {
+  return this->_data (NORX_TAG_TRAILER, NULL, t, len, NORX_MODE_ABSORB);
+}
+
+bool NorxStep::tag (uint8_t* t) {
+  if (!this->_data (NORX_TAG_FINAL, t, NULL, 0, NORX_MODE_ABSORB)) return 0;
+  this->expect = NULL;
+  return 1;
+}
+
+bool NorxStep::verify (const uint8_t* t) {
+  if (!this->_data (NORX_TAG_FINAL, NULL, NULL, 0, NORX_MODE_ABSORB)) return 0;
+  this->expect = t;
+  this->result = 0;
+  return 1;
+}
+
+/***************************************************************************
+ * test, against the instance's one shot AEAD : every width, D 1, 2 and 0,
+ * lengths around the rates, slices from a single G to whole F^R, the
+ * header and payload in two calls, a forged tag and calls out of order
+ */
+
+#define STEP_TEST_MAX 96
+
+const uint8_t STEP_TEST_LEN[] PROGMEM = { 0, 1, 39, 40, 41, 79, 80, 81, 95 };
+const uint16_t STEP_TEST_SLICE[] PROGMEM = { 1, 3, 8, 13, 64, 1000 };
+
+bool NorxStep::test (void) {
+  static uint8_t m[STEP_TEST_MAX];
+  static uint8_t c[STEP_TEST_MAX + NORX_MAX_TAG_SIZE];
+  static uint8_t e[STEP_TEST_MAX + NORX_MAX_TAG_SIZE];
+  uint8_t key[32], nonce[16], h[13], t[5];
+  uint8_t bits, d, i, j, k = 0, len, tl;
+  uint8_t saved = this->x->d;
+  uint16_t n;
+  bool ok = 1, r;
+
+  for (i=0;i<32;i++) key[i] = i * 5 + 1;
+  for (i=0;i<sizeof(h);i++) h[i] = i ^ 0x3c;
+  for (i=0;i<sizeof(t);i++) t[i] = i + 0x70;
+  for (i=0;i<STEP_TEST_MAX;i++) m[i] = i * 11;
+
+  for (bits=NORX_MIN_BITS;bits<=NORX_MAX_BITS;bits<<=1) {
+    Serial.print (F("* Testing step_"));
+    Serial.println (bits);
+    r = 1;
+    for (d=0;d<3;d++) {
+      this->x->d = (d + 1) % 3;
+      for (j=0;j<sizeof(STEP_TEST_LEN);j++,k++) {
+        len = pgm_read_byte (&(STEP_TEST_LEN[j]));
+        n = pgm_read_word (&(STEP_TEST_SLICE[k % (sizeof(STEP_TEST_SLICE)/sizeof(uint16_t))]));
+        for (i=0;i<16;i++) nonce[i] = len + i;
+        this->x->encrypt (bits, key, nonce, h, sizeof(h), m, len, t, sizeof(t), e);
+        tl = this->x->tag_size ();
+
+        r &= this->start (bits, key, nonce);
+        r &= !this->header (h, 3);
+        while (this->step (n));
+        r &= this->header (h, 3);
+        while (this->step (n));
+        r &= this->header (h + 3, sizeof(h) - 3);
+        while (this->step (n));
+        r &= this->encrypt (c, m, len >> 1);
+        while (this->step (n));
+        r &= this->encrypt (c + (len >> 1), m + (len >> 1), len - (len >> 1));
+        while (this->run (50));
+        r &= !this->header (h, 1);
+        r &= this->trailer (t, sizeof(t));
+        while (this->step (n));
+        r &= this->tag (c + len);
+        while (this->step (n));
+        r &= (memcmp (c, e, len + tl)==0);
+
+        // back, then with the tag's first bit flipped
+        for (i=0;i<2;i++) {
+          c[len] ^= i;
+          r &= this->start (bits, key, nonce);
+          while (this->step (n));
+          r &= this->header (h, sizeof(h));
+          r &= !this->decrypt (c, c, len);
+          while (this->step (n));
+          r &= this->decrypt (c, c, len);
+          while (this->step (n));
+          r &= this->trailer (t, sizeof(t));
+          while (this->step (n));
+          r &= this->verify (c + len);
+          while (this->run (50));
+          r &= (this->ok ()==!i);
+          r &= (memcmp (c, m, len)==0);
+          if (i) break;
+          memcpy (c, e, len);
+        }
+      }
+    }
+    ok &= _TEST (r);
+  }
+  this->x->d = saved;
+  return ok;
+}
@@ -0,0 +1,91 @@
+#ifndef __norx_step_h_
+#define __norx_step_h_
+
+#include "norx.h"
+
+/***************************************************************************
+ * resumable, time-sliced AEAD
+ *
+ * the same streaming API as Norx, but a call only queues the operation :
+ * the work is done by step or run, called from loop () until they return
+ * 0, so that no F^R holds the loop for longer than the caller allows.
+ *
+ *   step (n)   at most n calls of G (an F^R is 8 R of them), plus the
+ *              byte work in between : at most one rate block, the padding
+ *              or a lane copy
+ *   run (us)   about us microseconds of G calls. the clock is read once
+ *              per quantum of G calls, which is halved when one took more
+ *              than a quarter of the budget and doubled when it took less
+ *              than an eighth, so a call returns within about 1.25 times us
+ *
+ * a permutation is resumed at the G it was left at, the state never
+ * leaves the Norx instance, and a quantum starting on a round boundary
+ * with room for the rest of the F^R goes through Norx::_permute, unrolled
+ * or vectorized. whole blocks go as in Norx::_duplex when the quantum has
+ * room for their F^R, so with a budget of a few F^R the throughput is that
+ * of the monolithic path (norxbench, enc step against encrypt). step (8),
+ * a round at a time, costs a third to a half more on the host.
+ *
+ * every call but step and run returns 0 while an operation is pending,
+ * or if its phase has gone by, and start if bits is not built in. the
+ * buffers given must stay valid until the operation is done, verify's
+ * result is read with ok () then. the Norx instance must not be used
+ * directly meanwhile. the payload is never spread over the thread pool
+ * (norx_pool.h), and the stats probes (norx_stats.h) only see the F^R
+ * that run whole
+ */
+
+// G calls per clock reading in run, to start with and at most
+#define NORX_STEP_QUANTUM     8
+#define NORX_STEP_QUANTUM_MAX 1024
+
+class NorxStep {
+  private :
+    Norx* x;
+    // the pending F^R : state, rounds left, next G of the round
+    state_t* s;
+    uint8_t r;
+    uint8_t g;
+    // the operation : stage, where an opened block goes on, lane index
+    uint8_t stage;
+    uint8_t next;
+    uint8_t ret;
+    uint8_t i;
+    uint8_t p;
+    uint8_t mode;
+    const uint8_t* in;
+    uint8_t* out;
+    size_t len;
+    const uint8_t* expect;
+    bool result;
+    uint16_t quantum;
+
+    void _permute (state_t* s, uint8_t next);
+    void _G (void);
+    void _round (void);
+    void _advance (void);
+    bool _block (void);
+    bool _data (uint8_t p, uint8_t* out, const uint8_t* in, size_t len, uint8_t mode);
+
+  public :
+    NorxStep (Norx* norx);
+
+    bool start (uint8_t bits, const uint8_t* key, const uint8_t* nonce);
+    bool start (const norx_key_t* ctx, const uint8_t* nonce);
+    bool header (const uint8_t* h, size_t len);
+    bool encrypt (uint8_t* c, const uint8_t* m, size_t len);
+    bool decrypt (uint8_t* m, const uint8_t* c, size_t len);
+    bool trailer (const uint8_t* t, size_t len);
+    bool tag (uint8_t* t);
+    bool verify (const uint8_t* t);
+
+    // true while work remains
+    bool step (uint16_t n);
+    bool run (uint16_t us);
+    bool busy (void);
+    // verify's result, once done
+    bool ok (void);
+    bool test (void);
+};
+
+#endif
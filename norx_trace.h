@@ -0,0 +1,39 @@
+#ifndef __norx_trace_h_
+#define __norx_trace_h_
+
+/***************************************************************************
+ * compile-time state tracing
+ *
+ * NORX_TRACE_LEVEL selects what _init and the AEAD functions report :
+ *   NORX_TRACE_OFF      nothing, the trace points compile to nothing
+ *   NORX_TRACE_SUMMARY  the state after each step of init and each phase
+ *   NORX_TRACE_ROUND    the above, plus the state after every round of init
+ *
+ * the states go to the sink set with Norx::trace, or through dump_state
+ * over Serial when there is none. on the host, make TRACE=2 selects the
+ * level. included by norx.h, after state_t.
+ */
+
+#define NORX_TRACE_OFF     0
+#define NORX_TRACE_SUMMARY 1
+#define NORX_TRACE_ROUND   2
+
+#ifndef NORX_TRACE_LEVEL
+#define NORX_TRACE_LEVEL NORX_TRACE_OFF
+#endif
+
+typedef void (*norx_trace_sink_t) (state_t* s, char* label);
+
+#if NORX_TRACE_LEVEL >= NORX_TRACE_SUMMARY
+#define NORX_TRACE(s, label) this->_trace ((s), (char*)(label))
+#else
+#define NORX_TRACE(s, label)
+#endif
+
+#if NORX_TRACE_LEVEL >= NORX_TRACE_ROUND
+#define NORX_TRACE_ROUND_STATE(s, label) this->_trace ((s), (char*)(label))
+#else
+#define NORX_TRACE_ROUND_STATE(s, label)
+#endif
+
+#endif
@@ -0,0 +1,486 @@
+#include <string.h>
+#include "norxbench.h"
+#include "norx_simd.h"
+#include "norx_core.h"
+#include "norx_bi64.h"
+#include "cryptoutils.h"
+
+#if defined(ARDUINO_HOST)
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+const uint32_t BENCH_SIZES[] = { 0, 16, 64, 256, 1024, 4096, 16384, 65536, 262144, 1048576 };
+// random bytes per request, within NORX_BENCH_BUF
+const uint32_t BENCH_DRBG_SIZES[] = { 4, 16, 64 };
+// a D=1 context mid stream, for save and restore
+static uint8_t blob[NORX_SAVE_SIZE (NORX_MAX_BITS, 0)];
+static size_t blob_len;
+
+#if NORX_BATCH
+const uint32_t BENCH_BATCH_SIZES[] = { 16, 64, 256, 1024 };
+#endif
+
+// hex text of NORX_BENCH_HEX words, for the codec runs
+#if defined(ARDUINO_HOST)
+#define NORX_BENCH_HEX 16
+#else
+#define NORX_BENCH_HEX 4
+#endif
+static char hex[NORX_BENCH_HEX * 16 + 1];
+static uint64_t words[NORX_BENCH_HEX];
+
+#if NORX_BATCH
+NorxBench::NorxBench (Norx* norx) : step (norx), drbg (norx), batch (norx) {
+#else
+NorxBench::NorxBench (Norx* norx) : step (norx), drbg (norx) {
+#endif
+  this->norx = norx;
+  memset (&(this->s), 0, sizeof(this->s));
+  memset (this->k, 0, sizeof(this->k));
+  memset (this->n, 0, sizeof(this->n));
+  memset (this->g, 0, sizeof(this->g));
+#if NORX_64
+  memset (this->bi, 0, sizeof(this->bi));
+#endif
+  memset (this->key, 0, sizeof(this->key));
+  memset (&(this->ctx), 0, sizeof(this->ctx));
+  memset (this->buf, 0, sizeof(this->buf));
+}
+
+/***************************************************************************
+ * timing functions
+ */
+
+void NorxBench::_clock (bench_t* c, bench_t* n) {
+#if defined(ARDUINO_HOST)
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  *n = (bench_t)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+#if defined(__x86_64__) || defined(__i386__)
+  *c = __rdtsc ();
+#else
+  *c = 0;
+#endif
+#else
+  unsigned long us = micros ();
+  *n = us * 1000UL;
+  *c = us * clockCyclesPerMicrosecond ();
+#endif
+}
+
+/* nearest rank percentile, sorts v */
+bench_t NorxBench::_percentile (bench_t* v, uint8_t p) {
+  uint8_t i, j;
+  bench_t x;
+  for (i=1;i<NORX_BENCH_RUNS;i++) {
+    x = v[i];
+    for (j=i;(j>0)&&(v[j-1]>x);j--)
+      v[j] = v[j-1];
+    v[j] = x;
+  }
+  return v[((NORX_BENCH_RUNS-1) * (uint16_t)p) / 100];
+}
+
+void NorxBench::_measure (const char* name, void (NorxBench::*op)(void)) {
+  bench_t c0, c1, n0, n1;
+  uint32_t inner = 1, i;
+  uint8_t r;
+
+  // calibration, each sample must last NORX_BENCH_MIN_US
+  for (;;) {
+    this->_clock (&c0, &n0);
+    for (i=0;i<inner;i++) (this->*op) ();
+    this->_clock (&c1, &n1);
+    if ((n1 - n0) >= NORX_BENCH_MIN_US * 1000UL) break;
+    inner <<= 1;
+  }
+  for (r=0;r<NORX_BENCH_WARMUP;r++)
+    for (i=0;i<inner;i++) (this->*op) ();
+  for (r=0;r<NORX_BENCH_RUNS;r++) {
+    this->_clock (&c0, &n0);
+    for (i=0;i<inner;i++) (this->*op) ();
+    this->_clock (&c1, &n1);
+    this->cycles[r] = c1 - c0;
+    this->ns[r] = n1 - n0;
+  }
+  this->_report (name, inner);
+}
+
+void NorxBench::_report (const char* name, uint32_t inner) {
+  double c50, c99, n50, n99;
+  c50 = (double)this->_percentile (this->cycles, 50) / inner;
+  c99 = (double)this->_percentile (this->cycles, 99) / inner;
+  n50 = (double)this->_percentile (this->ns, 50) / inner;
+  n99 = (double)this->_percentile (this->ns, 99) / inner;
+
+  Serial.print (name);
+  Serial.print ('\t');
+  Serial.print (this->bits);
+  Serial.print ('\t');
+  Serial.print (this->rounds);
+  Serial.print ('\t');
+  Serial.print ((unsigned long)this->len);
+  Serial.print ('\t');
+  if (c50>0) {
+    Serial.print (c50, 1);
+    Serial.print ('\t');
+    Serial.print (c99, 1);
+    Serial.print ('\t');
+    if (this->len) Serial.print (c50 / this->len, 2);
+    else Serial.print ('-');
+  } else
+    Serial.print (F("-\t-\t-"));
+  Serial.print ('\t');
+  Serial.print (n50, 1);
+  Serial.print ('\t');
+  Serial.print (n99, 1);
+  Serial.print ('\t');
+  if (this->len) Serial.print (this->len * 1000.0 / n50, 2);
+  else Serial.print ('-');
+  Serial.println ();
+}
+
+/***************************************************************************
+ * benchmarked operations
+ */
+
+void NorxBench::_G_ref (void) {
+  if (this->bits==32) this->norx->__G_32 (&(this->g[0]), &(this->g[1]), &(this->g[2]), &(this->g[3]));
+  if (this->bits==64) this->norx->__G_64 (&(this->g[0]), &(this->g[1]), &(this->g[2]), &(this->g[3]));
+}
+
+void NorxBench::_G (void) {
+  this->norx->_G (&(this->s), 0, 4, 8, 12);
+}
+
+void NorxBench::_F (void) {
+  this->norx->_F (&(this->s));
+}
+
+void NorxBench::_permute (void) {
+  this->norx->_permute (&(this->s), this->rounds);
+}
+
+#if NORX_64
+/* NORX64 on uint64_t against the interleaved halves (norx_bi64.h), both
+   scalar whatever _permute picks */
+void NorxBench::_G_bi (void) {
+  NorxBi64F::G (this->bi[0], this->bi[1], 0, 4, 8, 12);
+}
+
+void NorxBench::_permute_u64 (void) {
+  if (this->rounds==4) NorxCore<uint64_t, 4>::permute (this->s.s64.w);
+  else NorxCore<uint64_t, 6>::permute (this->s.s64.w);
+}
+
+void NorxBench::_permute_bi (void) {
+  if (this->rounds==4) NorxBi64<4>::permute (this->s.s64.w);
+  else NorxBi64<6>::permute (this->s.s64.w);
+}
+#endif
+
+void NorxBench::_init (void) {
+  this->norx->_init (&(this->s), this->bits, this->rounds, 1, this->bits*4, this->k, this->n, 0);
+}
+
+/* Norx::post over every width built in, W is the widest */
+void NorxBench::_post (void) {
+  this->norx->post ();
+}
+
+/* per message setup, from the raw key and from a keyed context */
+void NorxBench::_start (void) {
+  this->norx->start (this->bits, this->key, this->key);
+}
+
+void NorxBench::_kstart (void) {
+  this->norx->start (&(this->ctx), this->key);
+}
+
+void NorxBench::_save (void) {
+  blob_len = this->norx->save (blob);
+}
+
+void NorxBench::_restore (void) {
+  this->norx->restore (blob, blob_len);
+}
+
+/* payload streamed through buf, which is only the whole message on the host */
+void NorxBench::_encrypt (void) {
+  uint8_t t[NORX_MAX_TAG_SIZE];
+  uint32_t left = this->len;
+  size_t c;
+  this->norx->start (this->bits, this->key, this->key);
+  while (left) {
+    c = min (left, (uint32_t)NORX_BENCH_BUF);
+    this->norx->encrypt (this->buf, this->buf, c);
+    left -= c;
+  }
+  this->norx->tag (t);
+}
+
+void NorxBench::_decrypt (void) {
+  uint8_t t[NORX_MAX_TAG_SIZE];
+  uint32_t left = this->len;
+  size_t c;
+  memset (t, 0, sizeof(t));
+  this->norx->start (this->bits, this->key, this->key);
+  while (left) {
+    c = min (left, (uint32_t)NORX_BENCH_BUF);
+    this->norx->decrypt (this->buf, this->buf, c);
+    left -= c;
+  }
+  this->norx->verify (t);
+}
+
+/* encrypt through NorxStep, in slices of NORX_BENCH_SLICE_US or of a round */
+void NorxBench::_step_run (void) {
+  uint8_t t[NORX_MAX_TAG_SIZE];
+  uint32_t left = this->len;
+  size_t c;
+  this->step.start (this->bits, this->key, this->key);
+  while (this->step.run (NORX_BENCH_SLICE_US));
+  while (left) {
+    c = min (left, (uint32_t)NORX_BENCH_BUF);
+    this->step.encrypt (this->buf, this->buf, c);
+    while (this->step.run (NORX_BENCH_SLICE_US));
+    left -= c;
+  }
+  this->step.tag (t);
+  while (this->step.run (NORX_BENCH_SLICE_US));
+}
+
+void NorxBench::_step_G (void) {
+  uint8_t t[NORX_MAX_TAG_SIZE];
+  uint32_t left = this->len;
+  size_t c;
+  this->step.start (this->bits, this->key, this->key);
+  while (this->step.step (8));
+  while (left) {
+    c = min (left, (uint32_t)NORX_BENCH_BUF);
+    this->step.encrypt (this->buf, this->buf, c);
+    while (this->step.step (8));
+    left -= c;
+  }
+  this->step.tag (t);
+  while (this->step.step (8));
+}
+
+/* len random bytes out of the buffered block, or from an F^R of their
+   own as when the permutation is called per request. reseeded whenever
+   NORX_DRBG_RESEED blocks have gone */
+void NorxBench::_drbg (void) {
+  if (!this->drbg.generate (this->buf, this->len)) {
+    this->drbg.reseed (this->key, sizeof(this->key));
+    this->drbg.generate (this->buf, this->len);
+  }
+}
+
+void NorxBench::_drbg_req (void) {
+  this->_drbg ();
+  this->drbg.ratchet ();
+}
+
+/* the codec against what it replaced : read_32_bits and read_64_bits went
+   a nibble at a time with a strlen per word, print_*_bits a digit at a
+   time through a range check. kept here as they were, for comparison */
+static uint8_t _old_nibble (uint8_t c) {
+  uint8_t v = 0;
+  if ((c>=0x30)&&(c<=0x39)) v = c - 0x30;
+  if ((c>=0x41)&&(c<=0x46)) v = c - 0x37;
+  if ((c>=0x61)&&(c<=0x66)) v = c - 0x57;
+  return v;
+}
+
+static uint64_t _old_read (uint8_t bits, const char* hex) {
+  uint64_t v = 0;
+  uint8_t i;
+  if (strlen (hex) < (size_t)(bits>>2)) return 0;
+  for (i=0;i<(bits>>2);i++) v = (v << 4) | _old_nibble (hex[i]);
+  return v;
+}
+
+#define _OLD_DIGIT(v) ((((v)>=0)&&((v)<=15)) ? (((v)>=10) ? (char)((v)+0x57) : (char)((v)+0x30)) : '?')
+
+static void _old_print (uint8_t bits, char* out, uint64_t v) {
+  uint8_t i, n = bits >> 2;
+  for (i=0;i<n;i++) out[i] = _OLD_DIGIT ((int)((v >> ((n - 1 - i) * 4)) & 0x0f));
+}
+
+/* the NORX_BENCH_HEX words of hex, one by one or all at once */
+void NorxBench::_rd_bits (void) {
+  uint8_t i;
+  for (i=0;i<NORX_BENCH_HEX;i++) words[i] = _old_read (this->bits, hex + i*(this->bits>>2));
+}
+
+void NorxBench::_hex_word (void) {
+  uint8_t i;
+  for (i=0;i<NORX_BENCH_HEX;i++) hex_read_word (this->bits, hex + i*(this->bits>>2), &(words[i]));
+}
+
+void NorxBench::_hex_words (void) {
+  hex_to_words (this->bits, words, NORX_BENCH_HEX, hex, this->len);
+}
+
+void NorxBench::_pr_bits (void) {
+  uint8_t i;
+  for (i=0;i<NORX_BENCH_HEX;i++) _old_print (this->bits, hex + i*(this->bits>>2), words[i]);
+}
+
+void NorxBench::_words_hex (void) {
+  words_to_hex (this->bits, hex, words, NORX_BENCH_HEX);
+}
+
+#if NORX_BATCH
+/* NORX_BENCH_JOBS messages of mlen bytes in buf, each with its own nonce */
+void NorxBench::_jobs (uint32_t mlen) {
+  uint8_t i;
+  for (i=0;i<NORX_BENCH_JOBS;i++) {
+    memset (&(this->jobs[i]), 0, sizeof(norx_job_t));
+    this->jobs[i].key = this->key;
+    this->jobs[i].nonce = this->buf + i;
+    this->jobs[i].in = this->buf + i*mlen;
+    this->jobs[i].out = this->buf + i*mlen;
+    this->jobs[i].len = mlen;
+    this->jobs[i].tag = this->tags[i];
+  }
+}
+
+void NorxBench::_batch (void) {
+  this->batch.encrypt (this->bits, this->jobs, NORX_BENCH_JOBS);
+}
+
+/* the same messages one after the other, for comparison */
+void NorxBench::_single (void) {
+  uint8_t i;
+  norx_job_t* j;
+  for (i=0;i<NORX_BENCH_JOBS;i++) {
+    j = &(this->jobs[i]);
+    this->norx->start (this->bits, j->key, j->nonce);
+    this->norx->encrypt (j->out, j->in, j->len);
+    this->norx->tag (j->tag);
+  }
+}
+#endif
+
+/***************************************************************************
+ * full run
+ */
+
+void NorxBench::run (void) {
+  uint8_t i, r;
+  uint16_t j;
+  uint8_t saved = this->norx->rounds;
+  uint8_t d = this->norx->d;
+
+#if NORX_SIMD
+  Serial.print (F("# F^R NORX32 "));
+  Serial.print (norx_simd_name (32));
+  Serial.print (F(", NORX64 "));
+  Serial.println (norx_simd_name (64));
+#endif
+  Serial.println (F("op\tW\tR\tbytes\tcyc/op\tcyc p99\tcyc/B\tns/op\tns p99\tMB/s"));
+  this->len = 0;
+  this->rounds = 1;
+  for (this->bits=32;this->bits<=NORX_MAX_BITS;this->bits+=32) {
+    this->s.bits = this->bits;
+    this->_measure ("G_ref", &NorxBench::_G_ref);
+    this->_measure ("G", &NorxBench::_G);
+    this->_measure ("F", &NorxBench::_F);
+#if NORX_64
+    if (this->bits==64) this->_measure ("G_bi", &NorxBench::_G_bi);
+#endif
+  }
+  this->bits = NORX_MAX_BITS;
+  this->_measure ("post", &NorxBench::_post);
+  // hex codec, bytes is the text. rd_bits and pr_bits are the old word
+  // functions, a word at a time like hex_word
+  this->rounds = 0;
+  for (this->bits=32;this->bits<=NORX_MAX_BITS;this->bits+=32) {
+    this->len = NORX_BENCH_HEX * (this->bits >> 2);
+    for (j=0;j<this->len;j++) hex[j] = "0123456789abcdefABCDEF"[(j * 7) % 22];
+    hex[this->len] = 0;
+    this->_measure ("rd_bits", &NorxBench::_rd_bits);
+    this->_measure ("hex_word", &NorxBench::_hex_word);
+    this->_measure ("hex_words", &NorxBench::_hex_words);
+    this->_measure ("pr_bits", &NorxBench::_pr_bits);
+    this->_measure ("words_hex", &NorxBench::_words_hex);
+  }
+  this->len = 0;
+  for (r=4;r<=6;r+=2) {
+    this->rounds = r;
+    this->norx->rounds = r;
+    for (this->bits=32;this->bits<=NORX_MAX_BITS;this->bits+=32) {
+      this->s.bits = this->bits;
+      this->len = 0;
+      this->_measure ("F^R", &NorxBench::_permute);
+#if NORX_64
+      if (this->bits==64) {
+        this->_measure ("F^R u64", &NorxBench::_permute_u64);
+        this->_measure ("F^R bi", &NorxBench::_permute_bi);
+      }
+#endif
+      this->_measure ("init", &NorxBench::_init);
+      this->norx->prepare (&(this->ctx), this->bits, this->key);
+      this->_measure ("start", &NorxBench::_start);
+      this->_measure ("kstart", &NorxBench::_kstart);
+      this->norx->start (this->bits, this->key, this->key);
+      this->norx->header (this->key, 7);
+      this->_measure ("save", &NorxBench::_save);
+      this->_measure ("restore", &NorxBench::_restore);
+      for (i=0;i<sizeof(BENCH_SIZES)/sizeof(uint32_t);i++) {
+        this->len = BENCH_SIZES[i];
+        if (this->len>NORX_BENCH_MAX_LEN) break;
+        this->_measure ("encrypt", &NorxBench::_encrypt);
+        this->_measure ("decrypt", &NorxBench::_decrypt);
+      }
+      // parallel payload at the largest size, lanes on the host thread pool
+      this->len = NORX_BENCH_MAX_LEN;
+      this->norx->d = 2;
+      this->_measure ("enc D2", &NorxBench::_encrypt);
+      this->norx->d = 0;
+      this->_measure ("enc D0", &NorxBench::_encrypt);
+      this->norx->d = d;
+      // time sliced (norx_step.h), against encrypt at the same size
+      this->_measure ("enc step", &NorxBench::_step_run);
+      this->_measure ("enc G8", &NorxBench::_step_G);
+      // random bytes, buffered against an F^R per request (norx_drbg.h)
+      this->drbg.seed (this->bits, this->key, sizeof(this->key));
+      for (i=0;i<sizeof(BENCH_DRBG_SIZES)/sizeof(uint32_t);i++) {
+        this->len = BENCH_DRBG_SIZES[i];
+        this->_measure ("drbg", &NorxBench::_drbg);
+        this->_measure ("drbg F^R", &NorxBench::_drbg_req);
+      }
+#if NORX_BATCH
+      // bytes is the whole batch, cyc/B and MB/s compare directly
+      for (i=0;i<sizeof(BENCH_BATCH_SIZES)/sizeof(uint32_t);i++) {
+        this->len = BENCH_BATCH_SIZES[i] * NORX_BENCH_JOBS;
+        if (this->len>NORX_BENCH_BUF) break;
+        this->_jobs (BENCH_BATCH_SIZES[i]);
+        this->_measure ("single", &NorxBench::_single);
+        this->_measure ("batch", &NorxBench::_batch);
+      }
+#endif
+    }
+#if NORX_SMALL
+    // NORX8 and NORX16, sequential only
+    this->norx->d = 1;
+    for (this->bits=8;this->bits<=16;this->bits+=8) {
+      this->s.bits = this->bits;
+      this->len = 0;
+      this->_measure ("F^R", &NorxBench::_permute);
+      this->_measure ("start", &NorxBench::_start);
+      for (i=0;i<sizeof(BENCH_SIZES)/sizeof(uint32_t);i++) {
+        this->len = BENCH_SIZES[i];
+        if (this->len>NORX_BENCH_MAX_LEN) break;
+        this->_measure ("encrypt", &NorxBench::_encrypt);
+      }
+    }
+    this->norx->d = d;
+#endif
+  }
+  this->norx->rounds = saved;
+}
@@ -0,0 +1,114 @@
+#ifndef __norxbench_h_
+#define __norxbench_h_
+
+#include "Arduino.h"
+#include "norx.h"
+#include "norx_batch.h"
+#include "norx_step.h"
+#include "norx_drbg.h"
+
+/***************************************************************************
+ * benchmark harness
+ *
+ * every operation is first calibrated (repeated until one sample lasts at
+ * least NORX_BENCH_MIN_US), warmed up, then sampled NORX_BENCH_RUNS times.
+ * the median and 99th percentile of cycles and nanoseconds per operation
+ * are reported, with cycles per byte and throughput for the AEAD runs.
+ *
+ * on the host, cycles come from the time stamp counter when there is one.
+ * on the board everything is derived from micros (), with its 4us
+ * resolution on a 16MHz AVR, so the calibration matters.
+ */
+
+#if defined(ARDUINO_HOST)
+#define NORX_BENCH_RUNS     101
+#define NORX_BENCH_WARMUP   5
+#define NORX_BENCH_MIN_US   200
+#define NORX_BENCH_MAX_LEN  1048576UL
+#define NORX_BENCH_BUF      NORX_BENCH_MAX_LEN
+#define NORX_BENCH_SLICE_US 20
+#else
+#define NORX_BENCH_RUNS     15
+#define NORX_BENCH_WARMUP   1
+#define NORX_BENCH_MIN_US   20000
+#define NORX_BENCH_MAX_LEN  1024UL
+#define NORX_BENCH_BUF      64
+#define NORX_BENCH_SLICE_US 1000
+#endif
+
+// batched runs, NORX_BENCH_JOBS messages of each of BENCH_BATCH_SIZES bytes
+#define NORX_BENCH_JOBS     64
+
+typedef unsigned long bench_t;
+
+class NorxBench {
+  private :
+    Norx*    norx;
+    NorxStep step;
+    NorxDrbg drbg;
+    uint8_t  bits;
+    uint8_t  rounds;
+    uint32_t len;
+    state_t  s;
+    stw      k[4];
+    stw      n[2];
+    stw      g[4];
+#if NORX_64
+    uint32_t bi[2][16];
+#endif
+    uint8_t  key[32];
+    norx_key_t ctx;
+    uint8_t  buf[NORX_BENCH_BUF];
+    bench_t  cycles[NORX_BENCH_RUNS];
+    bench_t  ns[NORX_BENCH_RUNS];
+#if NORX_BATCH
+    NorxBatch  batch;
+    norx_job_t jobs[NORX_BENCH_JOBS];
+    uint8_t    tags[NORX_BENCH_JOBS][NORX_MAX_TAG_SIZE];
+#endif
+
+    // timing
+    void _clock (bench_t* c, bench_t* n);
+    bench_t _percentile (bench_t* v, uint8_t p);
+    void _measure (const char* name, void (NorxBench::*op)(void));
+    void _report (const char* name, uint32_t inner);
+
+    // operations
+    void _G_ref (void);
+    void _G (void);
+    void _F (void);
+    void _permute (void);
+#if NORX_64
+    void _G_bi (void);
+    void _permute_u64 (void);
+    void _permute_bi (void);
+#endif
+    void _init (void);
+    void _post (void);
+    void _start (void);
+    void _kstart (void);
+    void _save (void);
+    void _restore (void);
+    void _encrypt (void);
+    void _decrypt (void);
+    void _step_run (void);
+    void _step_G (void);
+    void _drbg (void);
+    void _drbg_req (void);
+    void _rd_bits (void);
+    void _hex_word (void);
+    void _hex_words (void);
+    void _pr_bits (void);
+    void _words_hex (void);
+#if NORX_BATCH
+    void _jobs (uint32_t mlen);
+    void _batch (void);
+    void _single (void);
+#endif
+
+  public :
+    NorxBench (Norx* norx);
+    void run (void);
+};
+
+#endif
@@ -1,25 +1,65 @@
 
 #include "norx.h"
+#include "norx_stack.h"
+#include "norx_proto.h"
+#include "norxbench.h"
+
+// set to 1 to run the benchmark suite after the self test
+#define RUN_BENCH 0
 
 Norx norx;
+NorxProto proto (&norx);
+bool ok;
+uint8_t buf[64 + NORX_MAX_TAG_SIZE];
+unsigned long post_us;
 
-void setup () {
-  Serial.begin (9600);
-  Serial.println ("Norx testbed");
-  norx.test();
+// the quiet power-on self test, timed
+void power_on (void* arg) {
+  post_us = micros ();
+  ok = norx.post ();
+  post_us = micros () - post_us;
 }
 
-void loop () {
-  char c;
-  c = read_char ();
+#if NORX_DIAG
+// every test vector, printed
+void self_test (void* arg) {
+  ok &= norx.test ();
 }
+#endif
 
-int read_char () {
-  int c;
-  do {
-    c = Serial.read();
-  } while (c==-1);
-  return c;
+// one shot NORX64 (NORX32 with NORX_64=0) over 64 bytes, there and back
+void one_shot (void* arg) {
+  uint8_t key[32] = { 0 };
+  uint8_t nonce[16] = { 0 };
+  norx.encrypt (NORX_MAX_BITS, key, nonce, NULL, 0, buf, 64, NULL, 0, buf);
+  ok &= norx.decrypt (NORX_MAX_BITS, key, nonce, NULL, 0, buf, 64 + (NORX_MAX_BITS>>1), NULL, 0, buf);
 }
 
+void report (const __FlashStringHelper* what, size_t n) {
+  Serial.print (what);
+  Serial.print (n);
+  Serial.println (F(" bytes"));
+}
 
+void setup () {
+  Serial.begin (NORX_PROTO_BAUD);
+  Serial.println (F("Norx testbed"));
+  report (F("stack peak, power-on self test : "), norx_stack_measure (power_on, NULL));
+  Serial.print (ok ? F("power-on self test PASS, ") : F("power-on self test FAIL, "));
+  Serial.print (post_us);
+  Serial.println (F(" us"));
+#if NORX_DIAG
+  report (F("stack peak, self test : "), norx_stack_measure (self_test, NULL));
+#endif
+  report (F("stack peak, one shot AEAD : "), norx_stack_measure (one_shot, NULL));
+  report (F("static RAM : "), norx_stack_static ());
+#if RUN_BENCH
+  NorxBench bench (&norx);
+  bench.run ();
+#endif
+}
+
+// the board as an AEAD coprocessor, see norx_proto.h and host/client.cpp
+void loop () {
+  proto.poll ();
+}